@@ -0,0 +1,73 @@
+//
+//  append_benchmark.cpp
+//  fast-trie-benchmarks
+//
+//  Monotone streams of timestamps, each key a random step above the last,
+//  through append, plain insert and std::map with an end() hint.
+//
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "x_fast_trie.h"
+
+namespace {
+    typedef kora::x_fast_trie<uint64_t, 64, int> hashed_trie;
+    typedef kora::x_fast_trie<uint64_t, 64, int, std::allocator<std::pair<const uint64_t, int>>, kora::flat_levels> flat_trie;
+
+    std::vector<uint64_t> timestamps(size_t count, unsigned int seed) {
+        std::mt19937_64 random(seed);
+        std::vector<uint64_t> keys(count);
+        uint64_t key = 1500000000000000000ull;
+        for(size_t i = 0; i < count; i++) {
+            key += 1 + random() % 1000;
+            keys[i] = key;
+        }
+        return keys;
+    }
+}
+
+template<class Trie>
+static void BM_Append(benchmark::State& state) {
+    std::vector<uint64_t> keys = timestamps(state.range(0), 1);
+    for(auto _ : state) {
+        Trie trie;
+        for(size_t i = 0; i < keys.size(); i++)
+            trie.append(keys[i], (int)i);
+        benchmark::DoNotOptimize(trie.size());
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK_TEMPLATE(BM_Append, hashed_trie)->Range(1 << 12, 1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Append, flat_trie)->Range(1 << 12, 1 << 16)->Unit(benchmark::kMillisecond);
+
+template<class Trie>
+static void BM_MonotoneInsert(benchmark::State& state) {
+    std::vector<uint64_t> keys = timestamps(state.range(0), 1);
+    for(auto _ : state) {
+        Trie trie;
+        for(size_t i = 0; i < keys.size(); i++)
+            trie.insert({keys[i], (int)i});
+        benchmark::DoNotOptimize(trie.size());
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK_TEMPLATE(BM_MonotoneInsert, hashed_trie)->Range(1 << 12, 1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MonotoneInsert, flat_trie)->Range(1 << 12, 1 << 16)->Unit(benchmark::kMillisecond);
+
+static void BM_MonotoneMap(benchmark::State& state) {
+    std::vector<uint64_t> keys = timestamps(state.range(0), 1);
+    for(auto _ : state) {
+        std::map<uint64_t, int> map;
+        for(size_t i = 0; i < keys.size(); i++)
+            map.emplace_hint(map.end(), keys[i], (int)i);
+        benchmark::DoNotOptimize(map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK(BM_MonotoneMap)->Range(1 << 12, 1 << 16)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
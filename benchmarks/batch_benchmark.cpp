@@ -0,0 +1,97 @@
+//
+//  batch_benchmark.cpp
+//  fast-trie-benchmarks
+//
+//  One lookup at a time against find_many / lower_bound_many on tries well
+//  beyond the cache. Every iteration answers the next 1024 of a million
+//  random queries, so the trie stays cold.
+//
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+#include <memory>
+
+#include "x_fast_trie.h"
+
+namespace {
+    typedef std::allocator<std::pair<const unsigned int, int>> allocator_t;
+    typedef kora::x_fast_trie<unsigned int, 32, int, allocator_t, kora::hashed_levels> hashed_trie;
+    typedef kora::x_fast_trie<unsigned int, 32, int, allocator_t, kora::flat_levels> flat_trie;
+
+    const size_t query_count = 1024;
+    const size_t query_pool = 1 << 20;
+
+    std::vector<unsigned int> random_keys(size_t count, unsigned int seed) {
+        std::mt19937 random(seed);
+        std::vector<unsigned int> keys(count);
+        for(size_t i = 0; i < count; i++)
+            keys[i] = random();
+        return keys;
+    }
+}
+
+template<class Trie>
+static void BM_Find(benchmark::State& state) {
+    std::vector<unsigned int> keys = random_keys(state.range(0), 1);
+    Trie trie;
+    for(unsigned int key : keys)
+        trie.insert({key, 0});
+    std::vector<unsigned int> queries = random_keys(query_pool, 2);
+    for(size_t i = 0; i < query_pool; i += 2)
+        queries[i] = keys[queries[i] % keys.size()];
+    size_t offset = 0;
+    for(auto _ : state) {
+        for(size_t i = 0; i < query_count; i++)
+            benchmark::DoNotOptimize(trie.find(queries[offset + i]));
+        offset = (offset + query_count) % query_pool;
+    }
+    state.SetItemsProcessed(state.iterations() * query_count);
+}
+BENCHMARK_TEMPLATE(BM_Find, hashed_trie)->Range(1 << 16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Find, flat_trie)->Range(1 << 16, 1 << 20);
+
+template<class Trie>
+static void BM_FindMany(benchmark::State& state) {
+    std::vector<unsigned int> keys = random_keys(state.range(0), 1);
+    Trie trie;
+    for(unsigned int key : keys)
+        trie.insert({key, 0});
+    std::vector<unsigned int> queries = random_keys(query_pool, 2);
+    for(size_t i = 0; i < query_pool; i += 2)
+        queries[i] = keys[queries[i] % keys.size()];
+    size_t offset = 0;
+    std::vector<typename Trie::iterator> out(query_count, trie.end());
+    for(auto _ : state) {
+        trie.find_many(queries.data() + offset, query_count, out.begin());
+        benchmark::DoNotOptimize(out.data());
+        offset = (offset + query_count) % query_pool;
+    }
+    state.SetItemsProcessed(state.iterations() * query_count);
+}
+BENCHMARK_TEMPLATE(BM_FindMany, hashed_trie)->Range(1 << 16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_FindMany, flat_trie)->Range(1 << 16, 1 << 20);
+
+// Batch size 1 is the plain bottom() search, one key after the other.
+template<class Trie>
+static void BM_LowerBound(benchmark::State& state) {
+    std::vector<unsigned int> keys = random_keys(state.range(0), 1);
+    Trie trie;
+    for(unsigned int key : keys)
+        trie.insert({key, 0});
+    std::vector<unsigned int> queries = random_keys(query_pool, 2);
+    size_t offset = 0;
+    std::vector<typename Trie::iterator> out(query_count, trie.end());
+    size_t batch = state.range(1);
+    for(auto _ : state) {
+        for(size_t i = 0; i < query_count; i += batch)
+            trie.lower_bound_many(queries.data() + offset + i, batch, out.begin() + i);
+        benchmark::DoNotOptimize(out.data());
+        offset = (offset + query_count) % query_pool;
+    }
+    state.SetItemsProcessed(state.iterations() * query_count);
+}
+BENCHMARK_TEMPLATE(BM_LowerBound, hashed_trie)->ArgsProduct({{1 << 16, 1 << 20}, {1, 4, 16, 64}});
+BENCHMARK_TEMPLATE(BM_LowerBound, flat_trie)->ArgsProduct({{1 << 16, 1 << 20}, {1, 4, 16, 64}});
+
+BENCHMARK_MAIN();
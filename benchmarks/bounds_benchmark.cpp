@@ -0,0 +1,101 @@
+//
+//  bounds_benchmark.cpp
+//  fast-trie-benchmarks
+//
+//  lower_bound and predecessor on x_fast_trie against std::map::lower_bound
+//  for random 32-bit keys, and a scan of queries each a few keys past the
+//  last with and without the previous result as the hint.
+//
+
+#include <benchmark/benchmark.h>
+#include <map>
+#include <random>
+#include <vector>
+#include <memory>
+
+#include "x_fast_trie.h"
+
+namespace {
+    typedef std::allocator<std::pair<const unsigned int, int>> allocator_t;
+    typedef kora::x_fast_trie<unsigned int, 32, int, allocator_t, kora::hashed_levels> hashed_trie;
+    typedef kora::x_fast_trie<unsigned int, 32, int, allocator_t, kora::flat_levels> flat_trie;
+
+    std::vector<unsigned int> random_keys(size_t count, unsigned int seed) {
+        std::mt19937 random(seed);
+        std::vector<unsigned int> keys(count);
+        for(size_t i = 0; i < count; i++)
+            keys[i] = random();
+        return keys;
+    }
+}
+
+template<class Container>
+static void BM_LowerBound(benchmark::State& state) {
+    Container container;
+    for(unsigned int key : random_keys(state.range(0), 1))
+        container.insert({key, 0});
+    std::vector<unsigned int> queries = random_keys(1 << 16, 2);
+    size_t i = 0;
+    for(auto _ : state) {
+        benchmark::DoNotOptimize(container.lower_bound(queries[i++ & 0xFFFF]));
+    }
+}
+BENCHMARK_TEMPLATE(BM_LowerBound, std::map<unsigned int, int>)->RangeMultiplier(8)->Range(1 << 12, 1 << 18);
+BENCHMARK_TEMPLATE(BM_LowerBound, hashed_trie)->RangeMultiplier(8)->Range(1 << 12, 1 << 18);
+BENCHMARK_TEMPLATE(BM_LowerBound, flat_trie)->RangeMultiplier(8)->Range(1 << 12, 1 << 18);
+
+template<class Trie>
+static void BM_Predecessor(benchmark::State& state) {
+    Trie trie;
+    for(unsigned int key : random_keys(state.range(0), 1))
+        trie.insert({key, 0});
+    std::vector<unsigned int> queries = random_keys(1 << 16, 2);
+    size_t i = 0;
+    for(auto _ : state) {
+        benchmark::DoNotOptimize(trie.predecessor(queries[i++ & 0xFFFF]));
+    }
+}
+BENCHMARK_TEMPLATE(BM_Predecessor, hashed_trie)->RangeMultiplier(8)->Range(1 << 12, 1 << 18);
+BENCHMARK_TEMPLATE(BM_Predecessor, flat_trie)->RangeMultiplier(8)->Range(1 << 12, 1 << 18);
+
+static void forward_args(benchmark::internal::Benchmark* benchmark) {
+    for(int size = 1 << 12; size <= 1 << 18; size <<= 3) {
+        benchmark->Args({size, 1});
+        benchmark->Args({size, 16});
+    }
+}
+
+template<class Trie, bool Hinted>
+static void BM_ForwardLowerBound(benchmark::State& state) {
+    Trie trie;
+    for(unsigned int key : random_keys(state.range(0), 1))
+        trie.insert({key, 0});
+    
+    // Each query lies state.range(1) keys past the last result on average,
+    // so both variants wait for the previous search like a scan would.
+    std::mt19937 random(2);
+    std::vector<unsigned int> steps(1 << 16);
+    unsigned int step = 0xFFFFFFFFu / state.range(0) * 2 * state.range(1);
+    for(size_t i = 0; i < steps.size(); i++)
+        steps[i] = random() % step;
+    size_t i = 0;
+    typename Trie::const_iterator last = trie.cbegin();
+    for(auto _ : state) {
+        if(last == trie.cend())
+            last = trie.cbegin();
+        unsigned int key = last->first + steps[i++ & 0xFFFF];
+        if(key < last->first)
+            key = last->first;
+        if(Hinted)
+            last = trie.lower_bound(last, key);
+        else
+            last = trie.lower_bound(key);
+        benchmark::DoNotOptimize(last);
+    }
+}
+BENCHMARK_TEMPLATE(BM_ForwardLowerBound, hashed_trie, false)->Apply(forward_args);
+BENCHMARK_TEMPLATE(BM_ForwardLowerBound, hashed_trie, true)->Apply(forward_args);
+BENCHMARK_TEMPLATE(BM_ForwardLowerBound, flat_trie, false)->Apply(forward_args);
+BENCHMARK_TEMPLATE(BM_ForwardLowerBound, flat_trie, true)->Apply(forward_args);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,98 @@
+//
+//  build_benchmark.cpp
+//  fast-trie-benchmarks
+//
+//  Rebuilding an x_fast_trie from a sorted snapshot, key by key against
+//  build_sorted, and merging a sorted batch into a populated trie.
+//
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "x_fast_trie.h"
+
+namespace {
+    typedef kora::x_fast_trie<unsigned int, 32, int> hashed_trie;
+    typedef kora::x_fast_trie<unsigned int, 32, int, std::allocator<std::pair<const unsigned int, int>>, kora::flat_levels> flat_trie;
+
+    std::vector<std::pair<unsigned int, int>> sorted_pairs(size_t count, unsigned int seed) {
+        std::mt19937 random(seed);
+        std::vector<std::pair<unsigned int, int>> pairs(count);
+        for(size_t i = 0; i < count; i++)
+            pairs[i] = std::make_pair((unsigned int)random(), (int)i);
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end(), [](const std::pair<unsigned int, int>& a, const std::pair<unsigned int, int>& b) {
+            return a.first == b.first;
+        }), pairs.end());
+        return pairs;
+    }
+}
+
+template<class Trie>
+static void BM_InsertSorted(benchmark::State& state) {
+    std::vector<std::pair<unsigned int, int>> pairs = sorted_pairs(state.range(0), 1);
+    for(auto _ : state) {
+        Trie trie;
+        trie.insert(pairs.begin(), pairs.end());
+        benchmark::DoNotOptimize(trie.size());
+    }
+    state.SetItemsProcessed(state.iterations() * pairs.size());
+}
+BENCHMARK_TEMPLATE(BM_InsertSorted, hashed_trie)->Range(1 << 12, 1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_InsertSorted, flat_trie)->Range(1 << 12, 1 << 20)->Unit(benchmark::kMillisecond);
+
+template<class Trie>
+static void BM_BuildSorted(benchmark::State& state) {
+    std::vector<std::pair<unsigned int, int>> pairs = sorted_pairs(state.range(0), 1);
+    for(auto _ : state) {
+        Trie trie(kora::sorted_unique, pairs.begin(), pairs.end());
+        benchmark::DoNotOptimize(trie.size());
+    }
+    state.SetItemsProcessed(state.iterations() * pairs.size());
+}
+BENCHMARK_TEMPLATE(BM_BuildSorted, hashed_trie)->Range(1 << 12, 1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BuildSorted, flat_trie)->Range(1 << 12, 1 << 20)->Unit(benchmark::kMillisecond);
+
+// Merges range(0) sorted keys into a trie of four times as many.
+template<class Trie>
+static void BM_MergeOneByOne(benchmark::State& state) {
+    std::vector<std::pair<unsigned int, int>> existing = sorted_pairs(state.range(0) * 4, 1);
+    std::vector<std::pair<unsigned int, int>> batch = sorted_pairs(state.range(0), 2);
+    for(auto _ : state) {
+        state.PauseTiming();
+        std::unique_ptr<Trie> trie(new Trie(kora::sorted_unique, existing.begin(), existing.end()));
+        state.ResumeTiming();
+        trie->insert(batch.begin(), batch.end());
+        benchmark::DoNotOptimize(trie->size());
+        state.PauseTiming();
+        trie.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * batch.size());
+}
+BENCHMARK_TEMPLATE(BM_MergeOneByOne, hashed_trie)->Range(1 << 12, 1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MergeOneByOne, flat_trie)->Range(1 << 12, 1 << 16)->Unit(benchmark::kMillisecond);
+
+template<class Trie>
+static void BM_MergeSortedBatch(benchmark::State& state) {
+    std::vector<std::pair<unsigned int, int>> existing = sorted_pairs(state.range(0) * 4, 1);
+    std::vector<std::pair<unsigned int, int>> batch = sorted_pairs(state.range(0), 2);
+    for(auto _ : state) {
+        state.PauseTiming();
+        std::unique_ptr<Trie> trie(new Trie(kora::sorted_unique, existing.begin(), existing.end()));
+        state.ResumeTiming();
+        trie->insert_sorted_batch(batch.begin(), batch.end());
+        benchmark::DoNotOptimize(trie->size());
+        state.PauseTiming();
+        trie.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * batch.size());
+}
+BENCHMARK_TEMPLATE(BM_MergeSortedBatch, hashed_trie)->Range(1 << 12, 1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MergeSortedBatch, flat_trie)->Range(1 << 12, 1 << 16)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
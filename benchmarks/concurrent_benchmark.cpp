@@ -0,0 +1,95 @@
+//
+//  concurrent_benchmark.cpp
+//  fast-trie-benchmarks
+//
+//  Readers next to a single updating thread: thread 0 writes, every other
+//  thread runs finds and predecessor queries. A mutex-guarded x_fast_trie
+//  against concurrent_x_fast_trie.
+//
+
+#include <benchmark/benchmark.h>
+#include <mutex>
+#include <random>
+#include <memory>
+
+#include "x_fast_trie.h"
+#include "concurrent_x_fast_trie.h"
+
+namespace {
+    const size_t key_count = 1 << 16;
+
+    class locked_trie {
+    private:
+        mutable std::mutex _lock;
+        kora::x_fast_trie<unsigned int, 32, unsigned int, std::allocator<std::pair<const unsigned int, unsigned int>>, kora::flat_levels> _trie;
+    public:
+        void insert(unsigned int key, unsigned int value) {
+            std::lock_guard<std::mutex> guard(_lock);
+            _trie.insert({key, value});
+        }
+        void erase(unsigned int key) {
+            std::lock_guard<std::mutex> guard(_lock);
+            auto it = _trie.find(key);
+            if(it != _trie.end())
+                _trie.erase(it);
+        }
+        bool find(unsigned int key, unsigned int& value) const {
+            std::lock_guard<std::mutex> guard(_lock);
+            auto it = _trie.find(key);
+            if(it == _trie.cend())
+                return false;
+            value = it->second;
+            return true;
+        }
+        bool predecessor(unsigned int key, std::pair<unsigned int, unsigned int>& out) const {
+            std::lock_guard<std::mutex> guard(_lock);
+            auto it = _trie.predecessor(key);
+            if(it == _trie.cend())
+                return false;
+            out = *it;
+            return true;
+        }
+    };
+
+    class lock_free_trie: public kora::concurrent_x_fast_trie<unsigned int, 32, unsigned int> {
+    };
+
+    template<class Trie>
+    Trie& shared_trie() {
+        static Trie trie;
+        static std::once_flag filled;
+        std::call_once(filled, []() {
+            std::mt19937 random(1);
+            for(size_t i = 0; i < key_count; i++)
+                trie.insert(random(), 0);
+        });
+        return trie;
+    }
+}
+
+template<class Trie>
+static void BM_ReadMostly(benchmark::State& state) {
+    Trie& trie = shared_trie<Trie>();
+    std::mt19937 random(state.thread_index() + 2);
+    unsigned int value;
+    std::pair<unsigned int, unsigned int> neighbour;
+    for(auto _ : state) {
+        unsigned int key = random();
+        if(state.thread_index() == 0) {
+            if(key & 1)
+                trie.insert(key, key);
+            else
+                trie.erase(key);
+        } else if(key & 1) {
+            benchmark::DoNotOptimize(trie.find(key, value));
+        } else {
+            benchmark::DoNotOptimize(trie.predecessor(key, neighbour));
+        }
+    }
+    if(state.thread_index() != 0)
+        state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_ReadMostly, locked_trie)->ThreadRange(2, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ReadMostly, lock_free_trie)->ThreadRange(2, 16)->UseRealTime();
+
+BENCHMARK_MAIN();
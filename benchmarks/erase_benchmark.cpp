@@ -0,0 +1,114 @@
+//
+//  erase_benchmark.cpp
+//  fast-trie-benchmarks
+//
+//  Expiring the older half of a trie, one key at a time against
+//  erase_below, and compacting every other key of a trie against
+//  erase_sorted_batch.
+//
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "x_fast_trie.h"
+
+namespace {
+    typedef kora::x_fast_trie<unsigned int, 32, int> hashed_trie;
+    typedef kora::x_fast_trie<unsigned int, 32, int, std::allocator<std::pair<const unsigned int, int>>, kora::flat_levels> flat_trie;
+
+    std::vector<std::pair<unsigned int, int>> sorted_pairs(size_t count, unsigned int seed) {
+        std::mt19937 random(seed);
+        std::vector<std::pair<unsigned int, int>> pairs(count);
+        for(size_t i = 0; i < count; i++)
+            pairs[i] = std::make_pair((unsigned int)random(), (int)i);
+        std::sort(pairs.begin(), pairs.end());
+        return pairs;
+    }
+}
+
+template<class Trie>
+static void BM_EraseOneByOne(benchmark::State& state) {
+    std::vector<std::pair<unsigned int, int>> pairs = sorted_pairs(state.range(0), 1);
+    for(auto _ : state) {
+        state.PauseTiming();
+        std::unique_ptr<Trie> trie(new Trie(kora::sorted_unique, pairs.begin(), pairs.end()));
+        state.ResumeTiming();
+        typename Trie::iterator middle = trie->lower_bound(1u << 31);
+        for(typename Trie::iterator it = trie->begin(); it != middle;)
+            it = trie->erase(it);
+        benchmark::DoNotOptimize(trie->size());
+        state.PauseTiming();
+        trie.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * pairs.size() / 2);
+}
+BENCHMARK_TEMPLATE(BM_EraseOneByOne, hashed_trie)->Range(1 << 12, 1 << 18)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_EraseOneByOne, flat_trie)->Range(1 << 12, 1 << 18)->Unit(benchmark::kMillisecond);
+
+template<class Trie>
+static void BM_EraseBelow(benchmark::State& state) {
+    std::vector<std::pair<unsigned int, int>> pairs = sorted_pairs(state.range(0), 1);
+    for(auto _ : state) {
+        state.PauseTiming();
+        std::unique_ptr<Trie> trie(new Trie(kora::sorted_unique, pairs.begin(), pairs.end()));
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(trie->erase_below(1u << 31));
+        state.PauseTiming();
+        trie.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * pairs.size() / 2);
+}
+BENCHMARK_TEMPLATE(BM_EraseBelow, hashed_trie)->Range(1 << 12, 1 << 18)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_EraseBelow, flat_trie)->Range(1 << 12, 1 << 18)->Unit(benchmark::kMillisecond);
+
+template<class Trie>
+static void BM_CompactOneByOne(benchmark::State& state) {
+    std::vector<std::pair<unsigned int, int>> pairs = sorted_pairs(state.range(0), 1);
+    std::vector<unsigned int> keys;
+    for(size_t i = 0; i < pairs.size(); i += 2)
+        keys.push_back(pairs[i].first);
+    for(auto _ : state) {
+        state.PauseTiming();
+        std::unique_ptr<Trie> trie(new Trie(kora::sorted_unique, pairs.begin(), pairs.end()));
+        state.ResumeTiming();
+        for(size_t i = 0; i < keys.size(); i++) {
+            typename Trie::iterator it = trie->find(keys[i]);
+            if(it != trie->end())
+                trie->erase(it);
+        }
+        benchmark::DoNotOptimize(trie->size());
+        state.PauseTiming();
+        trie.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK_TEMPLATE(BM_CompactOneByOne, hashed_trie)->Range(1 << 12, 1 << 18)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CompactOneByOne, flat_trie)->Range(1 << 12, 1 << 18)->Unit(benchmark::kMillisecond);
+
+template<class Trie>
+static void BM_CompactSortedBatch(benchmark::State& state) {
+    std::vector<std::pair<unsigned int, int>> pairs = sorted_pairs(state.range(0), 1);
+    std::vector<unsigned int> keys;
+    for(size_t i = 0; i < pairs.size(); i += 2)
+        keys.push_back(pairs[i].first);
+    for(auto _ : state) {
+        state.PauseTiming();
+        std::unique_ptr<Trie> trie(new Trie(kora::sorted_unique, pairs.begin(), pairs.end()));
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(trie->erase_sorted_batch(keys.begin(), keys.end()));
+        state.PauseTiming();
+        trie.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK_TEMPLATE(BM_CompactSortedBatch, hashed_trie)->Range(1 << 12, 1 << 18)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CompactSortedBatch, flat_trie)->Range(1 << 12, 1 << 18)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,101 @@
+//
+//  hash_benchmark.cpp
+//  fast-trie-benchmarks
+//
+//  Per-key cost of hashing every level prefix of a key with each
+//  bits::level_hashes kernel the CPU runs, and of flat_levels inserts and
+//  erases that hash a leaf's whole path at once.
+//
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "x_fast_trie.h"
+
+namespace {
+    typedef std::allocator<std::pair<const uint64_t, int>> allocator_t;
+    typedef kora::x_fast_trie<uint64_t, 64, int, allocator_t, kora::flat_levels> flat_trie;
+    typedef kora::x_fast_trie<uint64_t, 64, int, allocator_t, kora::hashed_levels> hashed_trie;
+
+    std::vector<uint64_t> random_keys(size_t count, unsigned int seed) {
+        std::mt19937_64 random(seed);
+        std::vector<uint64_t> keys(count);
+        for(size_t i = 0; i < count; i++)
+            keys[i] = random();
+        return keys;
+    }
+
+    // The per-level loop the kernels replace.
+    void level_hashes_loop(uint64_t key, int width, int from, int to, uint64_t* out) {
+        for(int level = from; level < to; level++) {
+            *out++ = kora::bits::level_hash(level, key >> (width - 1 - level) >> 1);
+        }
+    }
+}
+
+static void run_kernel(benchmark::State& state, kora::bits::level_hash_kernel kernel) {
+    std::vector<uint64_t> keys = random_keys(1024, 1);
+    int width = (int)state.range(0);
+    uint64_t hashes[64];
+    size_t i = 0;
+    for(auto _ : state) {
+        kernel(keys[i++ & 1023] >> (64 - width), width, 0, width, hashes);
+        benchmark::DoNotOptimize(hashes);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_HashLoop(benchmark::State& state) {
+    run_kernel(state, level_hashes_loop);
+}
+BENCHMARK(BM_HashLoop)->Arg(32)->Arg(64);
+
+static void BM_HashScalar(benchmark::State& state) {
+    run_kernel(state, kora::bits::level_hashes_scalar);
+}
+BENCHMARK(BM_HashScalar)->Arg(32)->Arg(64);
+
+static void BM_HashAVX2(benchmark::State& state) {
+    if(!__builtin_cpu_supports("avx2")) {
+        state.SkipWithError("no AVX2");
+        return;
+    }
+    run_kernel(state, kora::bits::level_hashes_avx2);
+}
+BENCHMARK(BM_HashAVX2)->Arg(32)->Arg(64);
+
+static void BM_HashAVX512(benchmark::State& state) {
+    if(!__builtin_cpu_supports("avx512f") || !__builtin_cpu_supports("avx512dq")) {
+        state.SkipWithError("no AVX-512");
+        return;
+    }
+    run_kernel(state, kora::bits::level_hashes_avx512);
+}
+BENCHMARK(BM_HashAVX512)->Arg(32)->Arg(64);
+
+static void BM_HashDispatched(benchmark::State& state) {
+    run_kernel(state, kora::bits::level_hashes);
+}
+BENCHMARK(BM_HashDispatched)->Arg(32)->Arg(64);
+
+template<class Trie>
+static void BM_PathInsertErase(benchmark::State& state) {
+    std::vector<uint64_t> keys = random_keys(state.range(0), 1);
+    for(auto _ : state) {
+        Trie trie;
+        for(size_t i = 0; i < keys.size(); i++)
+            trie.insert({keys[i], 0});
+        for(size_t i = 0; i < keys.size(); i++)
+            trie.erase(keys[i]);
+        benchmark::DoNotOptimize(trie.size());
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK_TEMPLATE(BM_PathInsertErase, flat_trie)->RangeMultiplier(16)->Range(1 << 8, 1 << 16)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_PathInsertErase, hashed_trie)->RangeMultiplier(16)->Range(1 << 8, 1 << 16)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,62 @@
+//
+//  hint_benchmark.cpp
+//  fast-trie-benchmarks
+//
+//  Near-sorted insertion, each key a few above the last, with plain insert
+//  against insert hinted with the previous element. probes_per_key counts
+//  level table operations.
+//
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "x_fast_trie.h"
+
+namespace {
+    template<class KeyT, int Width>
+    struct counted {
+        typedef kora::x_fast_trie<KeyT, Width, int, std::allocator<std::pair<const KeyT, int>>, kora::hashed_levels, kora::counting_stats> trie;
+    };
+
+    template<class KeyT>
+    std::vector<KeyT> near_sorted_keys(size_t count, unsigned int seed) {
+        std::mt19937_64 random(seed);
+        std::vector<KeyT> keys(count);
+        KeyT key = (KeyT)random() >> 2;
+        for(size_t i = 0; i < count; i++) {
+            key += random() % 8;
+            keys[i] = key;
+        }
+        return keys;
+    }
+}
+
+template<class Trie, bool Hinted>
+static void BM_NearSortedInsert(benchmark::State& state) {
+    typedef typename std::remove_const<typename Trie::value_type::first_type>::type key_type;
+    std::vector<key_type> keys = near_sorted_keys<key_type>(state.range(0), 1);
+    uint64_t probes = 0;
+    for(auto _ : state) {
+        Trie trie;
+        typename Trie::iterator last = trie.end();
+        for(size_t i = 0; i < keys.size(); i++) {
+            if(Hinted)
+                last = trie.insert(last, {keys[i], 0});
+            else
+                trie.insert({keys[i], 0});
+        }
+        probes += trie.stats().insert.hash_probes;
+        benchmark::DoNotOptimize(trie.size());
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+    state.counters["probes_per_key"] = (double)probes / (state.iterations() * keys.size());
+}
+BENCHMARK_TEMPLATE(BM_NearSortedInsert, counted<uint32_t, 32>::trie, false)->Range(1 << 12, 1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_NearSortedInsert, counted<uint32_t, 32>::trie, true)->Range(1 << 12, 1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_NearSortedInsert, counted<uint64_t, 64>::trie, false)->Range(1 << 12, 1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_NearSortedInsert, counted<uint64_t, 64>::trie, true)->Range(1 << 12, 1 << 16)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
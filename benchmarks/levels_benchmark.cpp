@@ -0,0 +1,150 @@
+//
+//  levels_benchmark.cpp
+//  fast-trie-benchmarks
+//
+//  Compares the per-level unordered_map storage with the flat open-addressing
+//  table, both with the top 16 levels direct-indexed in front of them, and
+//  all with the dense table on 20-bit keys. Run with --benchmark_perf_counters=CACHE-MISSES to see cache misses
+//  next to the average probe length reported in the "probes" counter.
+//
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "x_fast_trie.h"
+
+namespace {
+    struct node {
+        void *left;
+        void *right;
+    };
+
+    typedef std::allocator<std::pair<const unsigned int, int>> allocator_t;
+    typedef kora::x_fast_trie<unsigned int, 32, int, allocator_t, kora::hashed_levels> hashed_trie;
+    typedef kora::x_fast_trie<unsigned int, 32, int, allocator_t, kora::flat_levels> flat_trie;
+    typedef kora::x_fast_trie<unsigned int, 32, int, allocator_t, kora::direct_top_levels<16>> top_hashed_trie;
+    typedef kora::x_fast_trie<unsigned int, 32, int, allocator_t, kora::direct_top_levels<16, kora::flat_levels>> top_flat_trie;
+    typedef kora::x_fast_trie<unsigned int, 20, int, allocator_t, kora::hashed_levels> small_hashed_trie;
+    typedef kora::x_fast_trie<unsigned int, 20, int, allocator_t, kora::flat_levels> small_flat_trie;
+    typedef kora::x_fast_trie<unsigned int, 20, int, allocator_t, kora::dense_levels> small_dense_trie;
+
+    std::vector<unsigned int> random_keys(size_t count, unsigned int seed) {
+        std::mt19937 random(seed);
+        std::vector<unsigned int> keys(count);
+        for(size_t i = 0; i < count; i++)
+            keys[i] = random();
+        return keys;
+    }
+
+    template<class Table>
+    void fill_levels(Table& table, const std::vector<unsigned int>& keys) {
+        node empty = { NULL, NULL };
+        for(unsigned int key : keys) {
+            for(int i = 0; i < 32; i++) {
+                unsigned int prefix = key >> (31 - i) >> 1;
+                if(!table.find(i, prefix))
+                    table.insert(i, prefix, empty);
+            }
+        }
+    }
+}
+
+template<class Table>
+static void BM_LevelLookup(benchmark::State& state) {
+    std::vector<unsigned int> keys = random_keys(state.range(0), 1);
+    Table table;
+    fill_levels(table, keys);
+    std::mt19937 random(2);
+    size_t i = 0;
+    for(auto _ : state) {
+        unsigned int key = keys[i++ % keys.size()];
+        int level = random() & 31;
+        benchmark::DoNotOptimize(table.find(level, key >> (31 - level) >> 1));
+    }
+    state.counters["probes"] = table.average_probe_length();
+}
+BENCHMARK_TEMPLATE(BM_LevelLookup, kora::hashed_level_table<unsigned int, node, 32, allocator_t>)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_LevelLookup, kora::flat_level_table<unsigned int, node, 32, allocator_t>)->Range(1 << 10, 1 << 20);
+
+template<class Trie>
+static void BM_TrieFind(benchmark::State& state) {
+    std::vector<unsigned int> keys = random_keys(state.range(0), 1);
+    Trie trie;
+    for(unsigned int key : keys)
+        trie.insert({key, 0});
+    size_t i = 0;
+    for(auto _ : state) {
+        benchmark::DoNotOptimize(trie.find(keys[i++ % keys.size()]));
+    }
+}
+BENCHMARK_TEMPLATE(BM_TrieFind, hashed_trie)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_TrieFind, flat_trie)->Range(1 << 10, 1 << 20);
+
+template<class Trie>
+static void BM_TrieLowerBound(benchmark::State& state) {
+    std::vector<unsigned int> keys = random_keys(state.range(0), 1);
+    std::vector<unsigned int> queries = random_keys(1 << 16, 2);
+    Trie trie;
+    for(unsigned int key : keys)
+        trie.insert({key, 0});
+    size_t i = 0;
+    for(auto _ : state) {
+        benchmark::DoNotOptimize(trie.lower_bound(queries[i++ & 0xFFFF]));
+    }
+}
+BENCHMARK_TEMPLATE(BM_TrieLowerBound, hashed_trie)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_TrieLowerBound, top_hashed_trie)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_TrieLowerBound, flat_trie)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_TrieLowerBound, top_flat_trie)->Range(1 << 10, 1 << 20);
+
+template<class Trie>
+static void BM_TrieInsert(benchmark::State& state) {
+    std::vector<unsigned int> keys = random_keys(state.range(0), 1);
+    for(auto _ : state) {
+        Trie trie;
+        for(unsigned int key : keys)
+            trie.insert({key, 0});
+        benchmark::DoNotOptimize(trie.size());
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK_TEMPLATE(BM_TrieInsert, hashed_trie)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_TrieInsert, top_hashed_trie)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_TrieInsert, flat_trie)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_TrieInsert, top_flat_trie)->Range(1 << 10, 1 << 18);
+
+template<class Trie>
+static void BM_SmallLowerBound(benchmark::State& state) {
+    std::vector<unsigned int> keys = random_keys(state.range(0), 1);
+    std::vector<unsigned int> queries = random_keys(1 << 16, 2);
+    Trie trie;
+    for(unsigned int key : keys)
+        trie.insert({key & 0xFFFFF, 0});
+    size_t i = 0;
+    for(auto _ : state) {
+        benchmark::DoNotOptimize(trie.lower_bound(queries[i++ & 0xFFFF] & 0xFFFFF));
+    }
+}
+BENCHMARK_TEMPLATE(BM_SmallLowerBound, small_hashed_trie)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_SmallLowerBound, small_flat_trie)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_SmallLowerBound, small_dense_trie)->Range(1 << 10, 1 << 18);
+
+template<class Trie>
+static void BM_SmallInsert(benchmark::State& state) {
+    std::vector<unsigned int> keys = random_keys(state.range(0), 1);
+    for(auto _ : state) {
+        Trie trie;
+        for(unsigned int key : keys)
+            trie.insert({key & 0xFFFFF, 0});
+        benchmark::DoNotOptimize(trie.size());
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK_TEMPLATE(BM_SmallInsert, small_hashed_trie)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_SmallInsert, small_flat_trie)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_SmallInsert, small_dense_trie)->Range(1 << 10, 1 << 18);
+
+BENCHMARK_MAIN();
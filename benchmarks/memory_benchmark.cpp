@@ -0,0 +1,88 @@
+//
+//  memory_benchmark.cpp
+//  fast-trie-benchmarks
+//
+//  Bytes per key of x_fast_trie against std::map. bytes_per_key is the heap
+//  growth glibc reports while the container is built, reported_per_key what
+//  memory_usage() accounts for. Sizes above 1M need tens of gigabytes, run
+//  them with --benchmark_filter.
+//
+
+#include <benchmark/benchmark.h>
+#include <malloc.h>
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "x_fast_trie.h"
+
+namespace {
+    template<class KeyT>
+    std::vector<std::pair<KeyT, int>> sorted_pairs(size_t count, unsigned int seed) {
+        std::mt19937_64 random(seed);
+        std::vector<std::pair<KeyT, int>> pairs(count);
+        for(size_t i = 0; i < count; i++)
+            pairs[i] = std::make_pair((KeyT)random(), (int)i);
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end(), [](const std::pair<KeyT, int>& a, const std::pair<KeyT, int>& b) {
+            return a.first == b.first;
+        }), pairs.end());
+        return pairs;
+    }
+
+    size_t heap_bytes() {
+        struct mallinfo2 info = mallinfo2();
+        return info.uordblks + info.hblkhd;
+    }
+
+    template<class KeyT>
+    size_t reported_bytes(const std::map<KeyT, int>&) {
+        return 0;
+    }
+
+    template<class KeyT, int Width, class ValueT, class Allocator, class Levels, class Stats>
+    size_t reported_bytes(const kora::x_fast_trie<KeyT, Width, ValueT, Allocator, Levels, Stats>& trie) {
+        return trie.memory_usage().total();
+    }
+
+    template<class KeyT, int Width>
+    struct tries {
+        typedef std::allocator<std::pair<const KeyT, int>> allocator_t;
+        typedef kora::x_fast_trie<KeyT, Width, int, allocator_t, kora::hashed_levels> hashed;
+        typedef kora::x_fast_trie<KeyT, Width, int, allocator_t, kora::flat_levels> flat;
+    };
+}
+
+template<class Container>
+static void BM_BytesPerKey(benchmark::State& state) {
+    typedef typename std::remove_const<typename Container::value_type::first_type>::type key_type;
+    std::vector<std::pair<key_type, int>> pairs = sorted_pairs<key_type>(state.range(0), 1);
+    for(auto _ : state) {
+        size_t before = heap_bytes();
+        Container container(pairs.begin(), pairs.end());
+        size_t after = heap_bytes();
+        state.counters["bytes_per_key"] = (double)(after - before + sizeof(container)) / pairs.size();
+        state.counters["reported_per_key"] = (double)reported_bytes(container) / pairs.size();
+    }
+}
+
+template<class Trie>
+struct sorted_trie: Trie {
+    template<class InputIt>
+    sorted_trie(InputIt first, InputIt last): Trie(kora::sorted_unique, first, last) {}
+};
+
+#define MEMORY_BENCHMARK(...) \
+    BENCHMARK_TEMPLATE(BM_BytesPerKey, __VA_ARGS__)->Arg(1000000)->Arg(10000000)->Arg(100000000)->Iterations(1)->Unit(benchmark::kMillisecond)
+
+MEMORY_BENCHMARK(sorted_trie<tries<uint32_t, 32>::hashed>);
+MEMORY_BENCHMARK(sorted_trie<tries<uint32_t, 32>::flat>);
+MEMORY_BENCHMARK(std::map<uint32_t, int>);
+MEMORY_BENCHMARK(sorted_trie<tries<uint64_t, 64>::hashed>);
+MEMORY_BENCHMARK(sorted_trie<tries<uint64_t, 64>::flat>);
+MEMORY_BENCHMARK(std::map<uint64_t, int>);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,68 @@
+//
+//  nodes_benchmark.cpp
+//  fast-trie-benchmarks
+//
+//  Insert/erase churn on x_fast_trie, the paths that follow leaf and
+//  descendant links on every level.
+//
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+#include "x_fast_trie.h"
+
+namespace {
+    typedef kora::x_fast_trie<unsigned int, 32, int> trie_t;
+    typedef kora::x_fast_trie<unsigned int, 32, int, kora::slab_allocator<std::pair<const unsigned int, int>>> slab_trie_t;
+
+    std::vector<unsigned int> random_keys(size_t count, unsigned int seed) {
+        std::mt19937 random(seed);
+        std::vector<unsigned int> keys(count);
+        for(size_t i = 0; i < count; i++)
+            keys[i] = random();
+        return keys;
+    }
+}
+
+static void BM_Insert(benchmark::State& state) {
+    std::vector<unsigned int> keys = random_keys(state.range(0), 1);
+    for(auto _ : state) {
+        trie_t trie;
+        for(unsigned int key : keys)
+            trie.insert({key, 0});
+        benchmark::DoNotOptimize(trie.size());
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK(BM_Insert)->Range(1 << 10, 1 << 16);
+
+template<class Trie>
+static void BM_EraseInsert(benchmark::State& state) {
+    std::vector<unsigned int> keys = random_keys(state.range(0), 1);
+    Trie trie;
+    for(unsigned int key : keys)
+        trie.insert({key, 0});
+    size_t i = 0;
+    for(auto _ : state) {
+        unsigned int key = keys[i++ % keys.size()];
+        trie.erase(trie.find(key));
+        trie.insert({key, 0});
+    }
+}
+BENCHMARK_TEMPLATE(BM_EraseInsert, trie_t)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_EraseInsert, slab_trie_t)->Range(1 << 10, 1 << 18);
+
+static void BM_Find(benchmark::State& state) {
+    std::vector<unsigned int> keys = random_keys(state.range(0), 1);
+    trie_t trie;
+    for(unsigned int key : keys)
+        trie.insert({key, 0});
+    size_t i = 0;
+    for(auto _ : state) {
+        benchmark::DoNotOptimize(trie.find(keys[i++ % keys.size()]));
+    }
+}
+BENCHMARK(BM_Find)->Range(1 << 10, 1 << 18);
+
+BENCHMARK_MAIN();
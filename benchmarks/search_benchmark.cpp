@@ -0,0 +1,86 @@
+//
+//  search_benchmark.cpp
+//  fast-trie-benchmarks
+//
+//  The level search on cache resident tries of several widths, where the
+//  instructions spent per probe rather than memory latency set the pace.
+//  Run with --benchmark_perf_counters=INSTRUCTIONS,BRANCHES to count them.
+//
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <memory>
+
+#include "x_fast_trie.h"
+
+namespace {
+    template<class KeyT, int Width>
+    struct flat_trie {
+        typedef kora::x_fast_trie<KeyT, Width, int, std::allocator<std::pair<const KeyT, int>>, kora::flat_levels> type;
+    };
+
+    template<class KeyT, int Width>
+    std::vector<KeyT> random_keys(size_t count, unsigned int seed) {
+        std::mt19937_64 random(seed);
+        std::vector<KeyT> keys(count);
+        for(size_t i = 0; i < count; i++)
+            keys[i] = (KeyT)(random() >> (64 - Width));
+        return keys;
+    }
+}
+
+template<class KeyT, int Width>
+static void BM_Find(benchmark::State& state) {
+    std::vector<KeyT> keys = random_keys<KeyT, Width>(state.range(0), 1);
+    typename flat_trie<KeyT, Width>::type trie;
+    for(KeyT key : keys)
+        trie.insert({key, 0});
+    std::vector<KeyT> queries = random_keys<KeyT, Width>(4096, 2);
+    size_t i = 0;
+    for(auto _ : state) {
+        benchmark::DoNotOptimize(trie.find(queries[i++ % queries.size()]));
+    }
+}
+BENCHMARK_TEMPLATE(BM_Find, uint16_t, 16)->Arg(1 << 10);
+BENCHMARK_TEMPLATE(BM_Find, uint32_t, 32)->Arg(1 << 10);
+BENCHMARK_TEMPLATE(BM_Find, uint64_t, 64)->Arg(1 << 10);
+
+// Inserting a key that is already there is the level search of insert and
+// nothing else.
+template<class KeyT, int Width>
+static void BM_InsertExisting(benchmark::State& state) {
+    std::vector<KeyT> keys = random_keys<KeyT, Width>(state.range(0), 1);
+    typename flat_trie<KeyT, Width>::type trie;
+    for(KeyT key : keys)
+        trie.insert({key, 0});
+    size_t i = 0;
+    for(auto _ : state) {
+        benchmark::DoNotOptimize(trie.insert({keys[i++ % keys.size()], 0}));
+    }
+}
+BENCHMARK_TEMPLATE(BM_InsertExisting, uint16_t, 16)->Arg(1 << 10);
+BENCHMARK_TEMPLATE(BM_InsertExisting, uint32_t, 32)->Arg(1 << 10);
+BENCHMARK_TEMPLATE(BM_InsertExisting, uint64_t, 64)->Arg(1 << 10);
+
+// Erasing and re-inserting the same key runs the level search of insert
+// without growing the trie.
+template<class KeyT, int Width>
+static void BM_EraseInsert(benchmark::State& state) {
+    std::vector<KeyT> keys = random_keys<KeyT, Width>(state.range(0), 1);
+    typename flat_trie<KeyT, Width>::type trie;
+    for(KeyT key : keys)
+        trie.insert({key, 0});
+    size_t i = 0;
+    for(auto _ : state) {
+        KeyT key = keys[i++ % keys.size()];
+        trie.erase(trie.find(key));
+        trie.insert({key, 0});
+    }
+}
+BENCHMARK_TEMPLATE(BM_EraseInsert, uint16_t, 16)->Arg(1 << 10);
+BENCHMARK_TEMPLATE(BM_EraseInsert, uint32_t, 32)->Arg(1 << 10);
+BENCHMARK_TEMPLATE(BM_EraseInsert, uint64_t, 64)->Arg(1 << 10);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,84 @@
+//
+//  sharded_benchmark.cpp
+//  fast-trie-benchmarks
+//
+//  Multi-threaded throughput of one x_fast_trie behind a global mutex
+//  against sharded_x_fast_trie, for a mix of 80% finds and 20% updates.
+//
+
+#include <benchmark/benchmark.h>
+#include <mutex>
+#include <random>
+#include <vector>
+#include <memory>
+
+#include "sharded_x_fast_trie.h"
+
+namespace {
+    typedef std::allocator<std::pair<const unsigned int, int>> allocator_t;
+    const size_t key_count = 1 << 16;
+
+    class locked_trie {
+    private:
+        mutable std::mutex _lock;
+        kora::x_fast_trie<unsigned int, 32, int, allocator_t, kora::flat_levels> _trie;
+    public:
+        void insert(unsigned int key, int value) {
+            std::lock_guard<std::mutex> guard(_lock);
+            _trie.insert({key, value});
+        }
+        void erase(unsigned int key) {
+            std::lock_guard<std::mutex> guard(_lock);
+            auto it = _trie.find(key);
+            if(it != _trie.end())
+                _trie.erase(it);
+        }
+        bool find(unsigned int key, int& value) const {
+            std::lock_guard<std::mutex> guard(_lock);
+            auto it = _trie.find(key);
+            if(it == _trie.cend())
+                return false;
+            value = it->second;
+            return true;
+        }
+    };
+
+    template<int ShardBits>
+    class sharded_trie: public kora::sharded_x_fast_trie<unsigned int, 32, int, ShardBits, allocator_t, kora::flat_levels> {
+    };
+
+    template<class Trie>
+    Trie& shared_trie() {
+        static Trie trie;
+        static std::once_flag filled;
+        std::call_once(filled, []() {
+            std::mt19937 random(1);
+            for(size_t i = 0; i < key_count; i++)
+                trie.insert(random(), 0);
+        });
+        return trie;
+    }
+}
+
+template<class Trie>
+static void BM_Mixed(benchmark::State& state) {
+    Trie& trie = shared_trie<Trie>();
+    std::mt19937 random(state.thread_index() + 2);
+    int value;
+    for(auto _ : state) {
+        unsigned int key = random();
+        unsigned int operation = key % 10;
+        if(operation == 0)
+            trie.insert(key, 0);
+        else if(operation == 1)
+            trie.erase(key);
+        else
+            benchmark::DoNotOptimize(trie.find(key, value));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_Mixed, locked_trie)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Mixed, sharded_trie<4>)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Mixed, sharded_trie<8>)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
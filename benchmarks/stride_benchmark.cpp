@@ -0,0 +1,111 @@
+//
+//  stride_benchmark.cpp
+//  fast-trie-benchmarks
+//
+//  strided_x_fast_trie for strides 1, 2, 4 and 8 against x_fast_trie on
+//  random 64-bit keys: building, find, lower_bound and erase, with the
+//  bytes per key memory_usage() reports and the level probes per query.
+//
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "strided_x_fast_trie.h"
+#include "x_fast_trie.h"
+
+namespace {
+    typedef std::allocator<std::pair<const uint64_t, int>> allocator_t;
+    typedef kora::x_fast_trie<uint64_t, 64, int, allocator_t, kora::hashed_levels, kora::counting_stats> plain_trie;
+
+    template<int Stride>
+    struct strided {
+        typedef kora::strided_x_fast_trie<uint64_t, 64, int, Stride, allocator_t, kora::hashed_levels, kora::counting_stats> trie;
+    };
+
+    std::vector<uint64_t> random_keys(size_t count, unsigned int seed) {
+        std::mt19937_64 random(seed);
+        std::vector<uint64_t> keys(count);
+        for(size_t i = 0; i < count; i++)
+            keys[i] = random();
+        return keys;
+    }
+
+    template<class Trie>
+    std::unique_ptr<Trie> build(const std::vector<uint64_t>& keys) {
+        std::unique_ptr<Trie> trie(new Trie());
+        for(size_t i = 0; i < keys.size(); i++)
+            trie->insert({keys[i], (int)i});
+        return trie;
+    }
+}
+
+template<class Trie>
+static void BM_StrideInsert(benchmark::State& state) {
+    std::vector<uint64_t> keys = random_keys(state.range(0), 1);
+    double bytes = 0;
+    for(auto _ : state) {
+        std::unique_ptr<Trie> trie = build<Trie>(keys);
+        state.PauseTiming();
+        bytes = (double)trie->memory_usage().total() / keys.size();
+        trie.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+    state.counters["bytes_per_key"] = bytes;
+}
+
+template<class Trie>
+static void BM_StrideFind(benchmark::State& state) {
+    std::vector<uint64_t> keys = random_keys(state.range(0), 1);
+    std::unique_ptr<Trie> trie = build<Trie>(keys);
+    trie->reset_stats();
+    size_t i = 0;
+    for(auto _ : state) {
+        benchmark::DoNotOptimize(trie->find(keys[i++ % keys.size()]));
+    }
+    state.counters["probes"] = (double)trie->stats().lookup.hash_probes / state.iterations();
+    state.counters["leaf_hops"] = (double)trie->stats().lookup.leaf_hops / state.iterations();
+}
+
+template<class Trie>
+static void BM_StrideLowerBound(benchmark::State& state) {
+    std::unique_ptr<Trie> trie = build<Trie>(random_keys(state.range(0), 1));
+    std::vector<uint64_t> queries = random_keys(1 << 16, 2);
+    trie->reset_stats();
+    size_t i = 0;
+    for(auto _ : state) {
+        benchmark::DoNotOptimize(trie->lower_bound(queries[i++ & 0xFFFF]));
+    }
+    state.counters["probes"] = (double)trie->stats().lookup.hash_probes / state.iterations();
+}
+
+template<class Trie>
+static void BM_StrideErase(benchmark::State& state) {
+    std::vector<uint64_t> keys = random_keys(state.range(0), 1);
+    for(auto _ : state) {
+        state.PauseTiming();
+        std::unique_ptr<Trie> trie = build<Trie>(keys);
+        state.ResumeTiming();
+        for(size_t i = 0; i < keys.size(); i++)
+            trie->erase(keys[i]);
+        benchmark::DoNotOptimize(trie->size());
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+#define STRIDE_BENCHMARKS(name) \
+    BENCHMARK_TEMPLATE(name, plain_trie)->RangeMultiplier(16)->Range(1 << 12, 1 << 16)->Unit(benchmark::kMicrosecond); \
+    BENCHMARK_TEMPLATE(name, strided<1>::trie)->RangeMultiplier(16)->Range(1 << 12, 1 << 16)->Unit(benchmark::kMicrosecond); \
+    BENCHMARK_TEMPLATE(name, strided<2>::trie)->RangeMultiplier(16)->Range(1 << 12, 1 << 16)->Unit(benchmark::kMicrosecond); \
+    BENCHMARK_TEMPLATE(name, strided<4>::trie)->RangeMultiplier(16)->Range(1 << 12, 1 << 16)->Unit(benchmark::kMicrosecond); \
+    BENCHMARK_TEMPLATE(name, strided<8>::trie)->RangeMultiplier(16)->Range(1 << 12, 1 << 16)->Unit(benchmark::kMicrosecond)
+
+STRIDE_BENCHMARKS(BM_StrideInsert);
+STRIDE_BENCHMARKS(BM_StrideFind);
+STRIDE_BENCHMARKS(BM_StrideLowerBound);
+STRIDE_BENCHMARKS(BM_StrideErase);
+
+BENCHMARK_MAIN();
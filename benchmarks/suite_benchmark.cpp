@@ -0,0 +1,359 @@
+//
+//  suite_benchmark.cpp
+//  fast-trie-benchmarks
+//
+//  Every operation of x_fast_trie against the standard containers, for
+//  Width 16/32/64 and four key distributions. Benchmarks are named
+//  <operation>/<container>/<width>/<keys>/<count>; track regressions with
+//
+//      suite_benchmark --benchmark_out=suite.json --benchmark_out_format=json
+//
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "x_fast_trie.h"
+
+namespace {
+    // Key distributions. Each returns count keys below 2^Width, possibly
+    // with repeats; queries are drawn from the same distribution.
+
+    template<class KeyT, int Width>
+    KeyT key_mask() {
+        return (KeyT)((((uint64_t)1 << (Width - 1)) << 1) - 1);
+    }
+
+    template<class KeyT, int Width>
+    std::vector<KeyT> uniform_keys(size_t count, unsigned int seed) {
+        std::mt19937_64 random(seed);
+        std::vector<KeyT> keys(count);
+        for(size_t i = 0; i < count; i++)
+            keys[i] = (KeyT)random() & key_mask<KeyT, Width>();
+        return keys;
+    }
+
+    // A run of consecutive keys from a random start, shuffled so the
+    // containers don't see them in order.
+    template<class KeyT, int Width>
+    std::vector<KeyT> sequential_keys(size_t count, unsigned int seed) {
+        std::mt19937_64 random(seed);
+        KeyT start = (KeyT)random() & key_mask<KeyT, Width>();
+        std::vector<KeyT> keys(count);
+        for(size_t i = 0; i < count; i++)
+            keys[i] = (KeyT)(start + i) & key_mask<KeyT, Width>();
+        std::shuffle(keys.begin(), keys.end(), random);
+        return keys;
+    }
+
+    // 64 random centres with keys spread a few hundred apart around them.
+    template<class KeyT, int Width>
+    std::vector<KeyT> clustered_keys(size_t count, unsigned int seed) {
+        std::mt19937_64 random(seed);
+        std::vector<KeyT> centres(64);
+        for(size_t i = 0; i < centres.size(); i++)
+            centres[i] = (KeyT)random() & key_mask<KeyT, Width>();
+        std::normal_distribution<double> offset(0, 256);
+        std::vector<KeyT> keys(count);
+        for(size_t i = 0; i < count; i++)
+            keys[i] = (KeyT)(centres[random() % centres.size()] + (int64_t)offset(random)) & key_mask<KeyT, Width>();
+        return keys;
+    }
+
+    // Ranks drawn with probability ~ 1/rank over a million ranks, scattered
+    // over the key space by an odd multiplier.
+    template<class KeyT, int Width>
+    std::vector<KeyT> zipf_keys(size_t count, unsigned int seed) {
+        const size_t ranks = 1 << 20;
+        static std::vector<double> cumulative;
+        if(cumulative.empty()) {
+            double sum = 0;
+            for(size_t r = 1; r <= ranks; r++) {
+                sum += 1.0 / r;
+                cumulative.push_back(sum);
+            }
+        }
+        std::mt19937_64 random(seed);
+        std::uniform_real_distribution<double> uniform(0, cumulative.back());
+        std::vector<KeyT> keys(count);
+        for(size_t i = 0; i < count; i++) {
+            uint64_t rank = std::lower_bound(cumulative.begin(), cumulative.end(), uniform(random)) - cumulative.begin();
+            keys[i] = (KeyT)(rank * 0x9E3779B97F4A7C15ull) & key_mask<KeyT, Width>();
+        }
+        return keys;
+    }
+
+    // Adapters giving every container the same operations.
+
+    template<class Trie>
+    struct trie_adapter {
+        typedef typename std::remove_const<typename Trie::value_type::first_type>::type key_type;
+        Trie container;
+
+        void insert(key_type key) { container.insert({key, 0}); }
+        bool find(key_type key) { return container.find(key) != container.end(); }
+        void erase(key_type key) {
+            typename Trie::iterator it = container.find(key);
+            if(it != container.end())
+                container.erase(it);
+        }
+        int& subscript(key_type key) { return container[key]; }
+        long iterate() {
+            long sum = 0;
+            for(typename Trie::iterator it = container.begin(); it != container.end(); ++it)
+                sum += it->second;
+            return sum;
+        }
+        bool predecessor(key_type key) { return container.predecessor(key) != container.end(); }
+    };
+
+    template<class KeyT>
+    struct map_adapter {
+        typedef KeyT key_type;
+        std::map<KeyT, int> container;
+
+        void insert(KeyT key) { container.insert({key, 0}); }
+        bool find(KeyT key) { return container.find(key) != container.end(); }
+        void erase(KeyT key) { container.erase(key); }
+        int& subscript(KeyT key) { return container[key]; }
+        long iterate() {
+            long sum = 0;
+            for(typename std::map<KeyT, int>::iterator it = container.begin(); it != container.end(); ++it)
+                sum += it->second;
+            return sum;
+        }
+        bool predecessor(KeyT key) { return container.lower_bound(key) != container.begin(); }
+    };
+
+    // Order in a std::set, values in a std::unordered_map.
+    template<class KeyT>
+    struct set_hash_adapter {
+        typedef KeyT key_type;
+        std::set<KeyT> order;
+        std::unordered_map<KeyT, int> values;
+
+        void insert(KeyT key) {
+            if(values.insert({key, 0}).second)
+                order.insert(key);
+        }
+        bool find(KeyT key) { return values.find(key) != values.end(); }
+        void erase(KeyT key) {
+            if(values.erase(key))
+                order.erase(key);
+        }
+        int& subscript(KeyT key) {
+            typename std::unordered_map<KeyT, int>::iterator it = values.find(key);
+            if(it != values.end())
+                return it->second;
+            order.insert(key);
+            return values[key];
+        }
+        long iterate() {
+            long sum = 0;
+            for(typename std::set<KeyT>::iterator it = order.begin(); it != order.end(); ++it)
+                sum += values.find(*it)->second;
+            return sum;
+        }
+        bool predecessor(KeyT key) { return order.lower_bound(key) != order.begin(); }
+    };
+
+    template<class KeyT>
+    struct sorted_vector_adapter {
+        typedef KeyT key_type;
+        typedef std::pair<KeyT, int> entry;
+        std::vector<entry> container;
+
+        typename std::vector<entry>::iterator position(KeyT key) {
+            return std::lower_bound(container.begin(), container.end(), entry(key, 0), [](const entry& a, const entry& b) {
+                return a.first < b.first;
+            });
+        }
+        void insert(KeyT key) {
+            typename std::vector<entry>::iterator it = position(key);
+            if(it == container.end() || it->first != key)
+                container.insert(it, entry(key, 0));
+        }
+        bool find(KeyT key) {
+            typename std::vector<entry>::iterator it = position(key);
+            return it != container.end() && it->first == key;
+        }
+        void erase(KeyT key) {
+            typename std::vector<entry>::iterator it = position(key);
+            if(it != container.end() && it->first == key)
+                container.erase(it);
+        }
+        int& subscript(KeyT key) {
+            typename std::vector<entry>::iterator it = position(key);
+            if(it == container.end() || it->first != key)
+                it = container.insert(it, entry(key, 0));
+            return it->second;
+        }
+        long iterate() {
+            long sum = 0;
+            for(size_t i = 0; i < container.size(); i++)
+                sum += container[i].second;
+            return sum;
+        }
+        bool predecessor(KeyT key) { return position(key) != container.begin(); }
+    };
+
+    // Operations. keys fill the container, queries drive the lookups.
+
+    template<class Adapter>
+    void fill(Adapter& adapter, const std::vector<typename Adapter::key_type>& keys) {
+        for(size_t i = 0; i < keys.size(); i++)
+            adapter.insert(keys[i]);
+    }
+
+    template<class Adapter>
+    void run_insert(benchmark::State& state, const std::vector<typename Adapter::key_type>& keys, const std::vector<typename Adapter::key_type>&) {
+        for(auto _ : state) {
+            Adapter adapter;
+            fill(adapter, keys);
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * keys.size());
+    }
+
+    template<class Adapter>
+    void run_find(benchmark::State& state, const std::vector<typename Adapter::key_type>& keys, const std::vector<typename Adapter::key_type>& queries) {
+        Adapter adapter;
+        fill(adapter, keys);
+        for(auto _ : state) {
+            size_t hits = 0;
+            for(size_t i = 0; i < queries.size(); i++)
+                hits += adapter.find(queries[i]);
+            benchmark::DoNotOptimize(hits);
+        }
+        state.SetItemsProcessed(state.iterations() * queries.size());
+    }
+
+    template<class Adapter>
+    void run_erase(benchmark::State& state, const std::vector<typename Adapter::key_type>& keys, const std::vector<typename Adapter::key_type>&) {
+        for(auto _ : state) {
+            state.PauseTiming();
+            Adapter adapter;
+            fill(adapter, keys);
+            state.ResumeTiming();
+            for(size_t i = 0; i < keys.size(); i++)
+                adapter.erase(keys[i]);
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * keys.size());
+    }
+
+    template<class Adapter>
+    void run_subscript(benchmark::State& state, const std::vector<typename Adapter::key_type>& keys, const std::vector<typename Adapter::key_type>& queries) {
+        Adapter adapter;
+        fill(adapter, keys);
+        for(auto _ : state) {
+            for(size_t i = 0; i < queries.size(); i++)
+                adapter.subscript(queries[i])++;
+        }
+        state.SetItemsProcessed(state.iterations() * queries.size());
+    }
+
+    template<class Adapter>
+    void run_iterate(benchmark::State& state, const std::vector<typename Adapter::key_type>& keys, const std::vector<typename Adapter::key_type>&) {
+        Adapter adapter;
+        fill(adapter, keys);
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(adapter.iterate());
+        }
+        state.SetItemsProcessed(state.iterations() * keys.size());
+    }
+
+    template<class Adapter>
+    void run_predecessor(benchmark::State& state, const std::vector<typename Adapter::key_type>& keys, const std::vector<typename Adapter::key_type>& queries) {
+        Adapter adapter;
+        fill(adapter, keys);
+        for(auto _ : state) {
+            size_t found = 0;
+            for(size_t i = 0; i < queries.size(); i++)
+                found += adapter.predecessor(queries[i]);
+            benchmark::DoNotOptimize(found);
+        }
+        state.SetItemsProcessed(state.iterations() * queries.size());
+    }
+
+    typedef const std::vector<size_t>& sizes_t;
+
+    // Registers every operation of one container for one key distribution.
+    // Sorted vector updates are quadratic and only run at the smallest size.
+    template<class Adapter, int Width>
+    void register_container(const std::string& container, const std::string& distribution, std::vector<typename Adapter::key_type> (*generate)(size_t, unsigned int), sizes_t sizes, bool quadratic_updates) {
+        typedef typename Adapter::key_type KeyT;
+        typedef void (*operation_t)(benchmark::State&, const std::vector<KeyT>&, const std::vector<KeyT>&);
+        struct operation { const char* name; operation_t run; bool updates; };
+        const operation operations[] = {
+            { "insert", &run_insert<Adapter>, true },
+            { "find", &run_find<Adapter>, false },
+            { "erase", &run_erase<Adapter>, true },
+            { "subscript", &run_subscript<Adapter>, true },
+            { "iterate", &run_iterate<Adapter>, false },
+            { "predecessor", &run_predecessor<Adapter>, false },
+        };
+        for(size_t o = 0; o < sizeof(operations) / sizeof(operations[0]); o++) {
+            for(size_t s = 0; s < sizes.size(); s++) {
+                if(quadratic_updates && operations[o].updates && s > 0)
+                    continue;
+                size_t count = sizes[s];
+                operation_t run = operations[o].run;
+                std::string name = std::string(operations[o].name) + "/" + container + "/" + std::to_string(Width) + "/" + distribution + "/" + std::to_string(count);
+                benchmark::RegisterBenchmark(name.c_str(), [run, generate, count](benchmark::State& state) {
+                    std::vector<KeyT> keys = generate(count, 1);
+                    std::vector<KeyT> queries = generate(count, 2);
+                    run(state, keys, queries);
+                });
+            }
+        }
+    }
+
+    template<class KeyT, int Width>
+    void register_width(sizes_t sizes) {
+        typedef std::allocator<std::pair<const KeyT, int>> allocator_t;
+        typedef trie_adapter<kora::x_fast_trie<KeyT, Width, int, allocator_t, kora::hashed_levels>> hashed_trie;
+        typedef trie_adapter<kora::x_fast_trie<KeyT, Width, int, allocator_t, kora::flat_levels>> flat_trie;
+        typedef std::vector<KeyT> (*generator_t)(size_t, unsigned int);
+        struct distribution { const char* name; generator_t generate; };
+        const distribution distributions[] = {
+            { "uniform", &uniform_keys<KeyT, Width> },
+            { "sequential", &sequential_keys<KeyT, Width> },
+            { "clustered", &clustered_keys<KeyT, Width> },
+            { "zipf", &zipf_keys<KeyT, Width> },
+        };
+        for(size_t d = 0; d < sizeof(distributions) / sizeof(distributions[0]); d++) {
+            const char* name = distributions[d].name;
+            generator_t generate = distributions[d].generate;
+            register_container<hashed_trie, Width>("x_fast_trie", name, generate, sizes, false);
+            register_container<flat_trie, Width>("x_fast_trie_flat", name, generate, sizes, false);
+            register_container<map_adapter<KeyT>, Width>("map", name, generate, sizes, false);
+            register_container<set_hash_adapter<KeyT>, Width>("set_unordered_map", name, generate, sizes, false);
+            register_container<sorted_vector_adapter<KeyT>, Width>("sorted_vector", name, generate, sizes, true);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    std::vector<size_t> sizes;
+    sizes.push_back(1 << 12);
+    sizes.push_back(1 << 16);
+    register_width<uint16_t, 16>(sizes);
+    register_width<uint32_t, 32>(sizes);
+    register_width<uint64_t, 64>(sizes);
+
+    benchmark::Initialize(&argc, argv);
+    if(benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,166 @@
+//
+//  concurrent_x_fast_trie.h
+//
+//  X-fast-trie with a single writer and lock-free readers.
+//  Author: Anil Anar.
+//
+
+#ifndef _concurrent_x_fast_trie_h
+#define _concurrent_x_fast_trie_h
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include <cstdint>
+
+#include "trie_bits.h"
+#include "trie_probing.h"
+#include "epoch.h"
+
+namespace kora {
+    // Same layout as x_fast_trie over flat_levels, with every shared field an
+    // atomic. One thread at a time may write (insert, insert_or_assign,
+    // erase); any number of threads may read concurrently without locks.
+    //
+    // The writer brackets each update with a sequence counter, odd while the
+    // update runs. Readers traverse the table and the leaf list optimistically
+    // and retry if the counter moved, checking it again before following any
+    // pointer they loaded so a torn read never reaches a stale object.
+    // Unlinked leaves and replaced tables are retired to an epoch_domain and
+    // freed once no reader can hold them. Leaves are never written after they
+    // are published, insert_or_assign swaps in a new one, which is why values
+    // have to be trivially copyable.
+    template<class KeyT, int Width, class ValueT, class Allocator = std::allocator<std::pair<const KeyT, ValueT>>>
+    class concurrent_x_fast_trie {
+        static_assert(std::is_trivially_copyable<ValueT>::value, "Readers copy values while they may be retired");
+
+    private:
+        struct leaf {
+            std::atomic<leaf*> left;
+            std::atomic<leaf*> right;
+            KeyT key;
+            ValueT value;
+        };
+
+        struct slot {
+            std::atomic<KeyT> prefix;
+            std::atomic<unsigned char> level;
+            std::atomic<unsigned char> distance;    // probe distance + 1, 0 marks an empty slot
+            std::atomic<leaf*> left;                // smallest leaf below the prefix
+            std::atomic<leaf*> right;               // largest leaf below the prefix
+        };
+
+        // A slot as the writer moves it around.
+        struct entry {
+            KeyT prefix;
+            unsigned char level;
+            unsigned char distance;
+            leaf* left;
+            leaf* right;
+        };
+
+        // Slots and their geometry are published together through one pointer.
+        struct table {
+            size_t mask;
+            int shift;
+            size_t size;
+            slot* slots;
+        };
+
+        // Adapts a table's slots to the probing loops, the writer being the
+        // only one to store.
+        struct slot_view {
+            typedef concurrent_x_fast_trie::entry entry;
+            const table* table_;
+            size_t mask() const { return table_->mask; }
+            unsigned char distance(size_t i) const { return table_->slots[i].distance.load(std::memory_order_relaxed); }
+            bool holds(size_t i, int level, KeyT prefix) const;
+            entry load(size_t i) const { return concurrent_x_fast_trie::load(table_->slots[i]); }
+            void store(size_t i, const entry& entry_) { concurrent_x_fast_trie::store(table_->slots[i], entry_); }
+            void vacate(size_t i) { table_->slots[i].distance.store(0, std::memory_order_relaxed); }
+        };
+
+        // Adapts a table to bits::level_search.
+        struct table_view {
+            const table* table_;
+            const slot* find(int level, KeyT prefix) const;
+        };
+
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<leaf> leaf_allocator_t;
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<slot> slot_allocator_t;
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<table> table_allocator_t;
+
+        static const size_t reclaim_threshold = 64;
+
+        leaf_allocator_t _leaf_allocator;
+        slot_allocator_t _slot_allocator;
+        table_allocator_t _table_allocator;
+
+        std::atomic<uint64_t> _version;
+        std::atomic<size_t> _count;
+        std::atomic<table*> _table;
+        std::atomic<leaf*> _leaf_list;
+
+        mutable epoch_domain<> _epochs;
+
+        concurrent_x_fast_trie(const concurrent_x_fast_trie&);
+        concurrent_x_fast_trie& operator=(const concurrent_x_fast_trie&);
+
+        static const slot* locate(const table* table_, int level, KeyT prefix);
+        static size_t home(const table* table_, int level, KeyT prefix);
+        static entry load(const slot& slot_);
+        static void store(slot& slot_, const entry& entry_);
+
+        table* allocate_table(size_t capacity);
+        static void free_table(void* owner, void* pointer);
+        static void free_leaf(void* owner, void* pointer);
+        void retire(void* pointer, void (*deleter)(void*, void*));
+
+        // Readers.
+        uint64_t read_begin() const;
+        bool read_valid(uint64_t version) const;
+        const slot* read_bottom(KeyT key) const;
+        bool read_lower(KeyT key, uint64_t version, leaf*& found) const;
+        bool read_ceiling(KeyT key, uint64_t version, leaf*& found) const;
+        bool read_higher(KeyT key, uint64_t version, leaf*& found) const;
+
+        // Writer.
+        void write_begin();
+        void write_end();
+        slot* writer_find(int level, KeyT prefix);
+        bool writer_place(table* table_, entry& entry_);
+        void writer_insert(int level, KeyT prefix, leaf* left, leaf* right);
+        void writer_erase(int level, KeyT prefix);
+        void writer_grow(const entry* homeless);
+        leaf* writer_leaf(KeyT key);
+        leaf* writer_lower(KeyT key);
+        leaf* new_leaf(KeyT key, const ValueT& value);
+        void link_after(leaf* marker, leaf* new_leaf);
+
+    public:
+        typedef std::pair<KeyT, ValueT> value_type;
+
+        concurrent_x_fast_trie();
+        ~concurrent_x_fast_trie();
+
+        // Writer side, one thread at a time.
+        bool insert(const KeyT& key, const ValueT& value);
+        void insert_or_assign(const KeyT& key, const ValueT& value);
+        bool erase(const KeyT& key);
+
+        // Reader side, any thread.
+        bool find(const KeyT& key, ValueT& value) const;
+        bool contains(const KeyT& key) const;
+        bool predecessor(const KeyT& key, value_type& out) const;
+        bool successor(const KeyT& key, value_type& out) const;
+        bool lower_bound(const KeyT& key, value_type& out) const;
+
+        size_t size() const;
+        bool empty() const;
+    };
+}
+
+#include "concurrent_x_fast_trie_impl.h"
+
+#endif
@@ -0,0 +1,505 @@
+//
+//  concurrent_x_fast_trie_impl.h
+//
+//  X-fast-trie with a single writer and lock-free readers.
+//  Author: Anil Anar.
+//
+
+#ifndef _concurrent_x_fast_trie_impl_h
+#define _concurrent_x_fast_trie_impl_h
+
+#define __TMPL      template<class KeyT, int Width, class ValueT, class Allocator>
+#define __CLS       kora::concurrent_x_fast_trie<KeyT, Width, ValueT, Allocator>
+#define __INNER     typename __CLS
+
+#include <thread>
+#include <new>
+
+__TMPL
+__CLS::concurrent_x_fast_trie():
+_version(0),
+_count(0),
+_table(NULL),
+_leaf_list(NULL) {
+    _table.store(allocate_table(16), std::memory_order_relaxed);
+}
+
+__TMPL
+__CLS::~concurrent_x_fast_trie() {
+    leaf *current = _leaf_list.load(std::memory_order_relaxed);
+    for(size_t i = 0; i < _count.load(std::memory_order_relaxed); i++) {
+        leaf *next = current->right.load(std::memory_order_relaxed);
+        free_leaf(this, current);
+        current = next;
+    }
+    free_table(this, _table.load(std::memory_order_relaxed));
+}
+
+__TMPL
+size_t __CLS::home(const table* table_, int level, KeyT prefix) {
+    return (size_t)(bits::level_hash(level, (uint64_t)prefix) >> table_->shift);
+}
+
+__TMPL
+const __INNER::slot* __CLS::locate(const table* table_, int level, KeyT prefix) {
+    // The bound on the run keeps a reader of a torn table from looping.
+    slot_view view = { table_ };
+    size_t found = probing::locate(view, home(table_, level, prefix), level, prefix);
+    return found <= table_->mask ? table_->slots + found : NULL;
+}
+
+__TMPL
+bool __CLS::slot_view::holds(size_t i, int level, KeyT prefix) const {
+    const slot& slot_ = table_->slots[i];
+    return slot_.prefix.load(std::memory_order_relaxed) == prefix && slot_.level.load(std::memory_order_relaxed) == level;
+}
+
+__TMPL
+const __INNER::slot* __CLS::table_view::find(int level, KeyT prefix) const {
+    return locate(table_, level, prefix);
+}
+
+__TMPL
+__INNER::entry __CLS::load(const slot& slot_) {
+    entry entry_;
+    entry_.prefix = slot_.prefix.load(std::memory_order_relaxed);
+    entry_.level = slot_.level.load(std::memory_order_relaxed);
+    entry_.distance = slot_.distance.load(std::memory_order_relaxed);
+    entry_.left = slot_.left.load(std::memory_order_relaxed);
+    entry_.right = slot_.right.load(std::memory_order_relaxed);
+    return entry_;
+}
+
+__TMPL
+void __CLS::store(slot& slot_, const entry& entry_) {
+    slot_.prefix.store(entry_.prefix, std::memory_order_relaxed);
+    slot_.level.store(entry_.level, std::memory_order_relaxed);
+    slot_.left.store(entry_.left, std::memory_order_relaxed);
+    slot_.right.store(entry_.right, std::memory_order_relaxed);
+    slot_.distance.store(entry_.distance, std::memory_order_relaxed);
+}
+
+__TMPL
+__INNER::table* __CLS::allocate_table(size_t capacity) {
+    table *table_ = std::allocator_traits<table_allocator_t>::allocate(_table_allocator, 1);
+    table_->mask = capacity - 1;
+    table_->shift = 64;
+    for(size_t c = capacity; c > 1; c >>= 1) {
+        table_->shift--;
+    }
+    table_->size = 0;
+    table_->slots = std::allocator_traits<slot_allocator_t>::allocate(_slot_allocator, capacity);
+    for(size_t i = 0; i < capacity; i++) {
+        slot *slot_ = ::new((void *)(table_->slots + i)) slot;
+        slot_->distance.store(0, std::memory_order_relaxed);
+    }
+    return table_;
+}
+
+__TMPL
+void __CLS::free_table(void* owner, void* pointer) {
+    __CLS *trie = static_cast<__CLS *>(owner);
+    table *table_ = static_cast<table *>(pointer);
+    std::allocator_traits<slot_allocator_t>::deallocate(trie->_slot_allocator, table_->slots, table_->mask + 1);
+    std::allocator_traits<table_allocator_t>::deallocate(trie->_table_allocator, table_, 1);
+}
+
+__TMPL
+void __CLS::free_leaf(void* owner, void* pointer) {
+    __CLS *trie = static_cast<__CLS *>(owner);
+    std::allocator_traits<leaf_allocator_t>::deallocate(trie->_leaf_allocator, static_cast<leaf *>(pointer), 1);
+}
+
+__TMPL
+void __CLS::retire(void* pointer, void (*deleter)(void*, void*)) {
+    _epochs.retire(pointer, deleter, this);
+    if(_epochs.pending() >= reclaim_threshold)
+        _epochs.reclaim();
+}
+
+__TMPL
+uint64_t __CLS::read_begin() const {
+    for(;;) {
+        uint64_t version = _version.load(std::memory_order_acquire);
+        if((version & 1) == 0)
+            return version;
+        std::this_thread::yield();
+    }
+}
+
+__TMPL
+bool __CLS::read_valid(uint64_t version) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return _version.load(std::memory_order_relaxed) == version;
+}
+
+__TMPL
+const __INNER::slot* __CLS::read_bottom(KeyT key) const {
+    // Only slots of the table are read here, those stay allocated while the
+    // reader is pinned no matter what the writer does.
+    table_view view = { _table.load(std::memory_order_acquire) };
+    return bits::level_search<KeyT, Width, 0, Width>::deepest(view, key, (const slot *)NULL);
+}
+
+__TMPL
+bool __CLS::read_lower(KeyT key, uint64_t version, leaf*& found) const {
+    const slot *bottom = read_bottom(key);
+    if(!bottom) {
+        found = NULL;
+        return read_valid(version);
+    }
+    leaf *left = bottom->left.load(std::memory_order_relaxed);
+    leaf *right = bottom->right.load(std::memory_order_relaxed);
+    if(!read_valid(version))
+        return false;
+    if(right->key < key) {
+        found = right;
+        return true;
+    }
+    if(left->key < key) {
+        found = left;
+        return true;
+    }
+    leaf *outer = left->left.load(std::memory_order_relaxed);
+    if(!read_valid(version))
+        return false;
+    found = outer->key < key ? outer : NULL;
+    return true;
+}
+
+__TMPL
+bool __CLS::read_ceiling(KeyT key, uint64_t version, leaf*& found) const {
+    const slot *bottom = read_bottom(key);
+    if(!bottom) {
+        found = NULL;
+        return read_valid(version);
+    }
+    leaf *left = bottom->left.load(std::memory_order_relaxed);
+    leaf *right = bottom->right.load(std::memory_order_relaxed);
+    if(!read_valid(version))
+        return false;
+    if(left->key >= key) {
+        found = left;
+        return true;
+    }
+    if(right->key >= key) {
+        found = right;
+        return true;
+    }
+    leaf *outer = right->right.load(std::memory_order_relaxed);
+    leaf *head = _leaf_list.load(std::memory_order_relaxed);
+    if(!read_valid(version))
+        return false;
+    found = outer != head ? outer : NULL;
+    return true;
+}
+
+__TMPL
+bool __CLS::read_higher(KeyT key, uint64_t version, leaf*& found) const {
+    if(!read_ceiling(key, version, found))
+        return false;
+    if(!found || found->key != key)
+        return true;
+    leaf *next = found->right.load(std::memory_order_relaxed);
+    leaf *head = _leaf_list.load(std::memory_order_relaxed);
+    if(!read_valid(version))
+        return false;
+    found = next != head ? next : NULL;
+    return true;
+}
+
+__TMPL
+bool __CLS::find(const KeyT& key, ValueT& value) const {
+    epoch_domain<>::guard guard = _epochs.pin();
+    for(;;) {
+        uint64_t version = read_begin();
+        const slot *node = locate(_table.load(std::memory_order_acquire), Width - 1, key >> 1);
+        leaf *candidate = NULL;
+        if(node)
+            candidate = (key & 1) == 1 ? node->right.load(std::memory_order_relaxed) : node->left.load(std::memory_order_relaxed);
+        if(!read_valid(version))
+            continue;
+        if(!candidate || candidate->key != key)
+            return false;
+        value = candidate->value;
+        return true;
+    }
+}
+
+__TMPL
+bool __CLS::contains(const KeyT& key) const {
+    ValueT value;
+    return find(key, value);
+}
+
+__TMPL
+bool __CLS::predecessor(const KeyT& key, value_type& out) const {
+    epoch_domain<>::guard guard = _epochs.pin();
+    leaf *found;
+    while(!read_lower(key, read_begin(), found));
+    if(!found)
+        return false;
+    out = value_type(found->key, found->value);
+    return true;
+}
+
+__TMPL
+bool __CLS::successor(const KeyT& key, value_type& out) const {
+    epoch_domain<>::guard guard = _epochs.pin();
+    leaf *found;
+    while(!read_higher(key, read_begin(), found));
+    if(!found)
+        return false;
+    out = value_type(found->key, found->value);
+    return true;
+}
+
+__TMPL
+bool __CLS::lower_bound(const KeyT& key, value_type& out) const {
+    epoch_domain<>::guard guard = _epochs.pin();
+    leaf *found;
+    while(!read_ceiling(key, read_begin(), found));
+    if(!found)
+        return false;
+    out = value_type(found->key, found->value);
+    return true;
+}
+
+__TMPL
+size_t __CLS::size() const {
+    return _count.load(std::memory_order_relaxed);
+}
+
+__TMPL
+bool __CLS::empty() const {
+    return size() == 0;
+}
+
+__TMPL
+void __CLS::write_begin() {
+    _version.store(_version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+__TMPL
+void __CLS::write_end() {
+    _version.store(_version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+__TMPL
+__INNER::slot* __CLS::writer_find(int level, KeyT prefix) {
+    return const_cast<slot *>(locate(_table.load(std::memory_order_relaxed), level, prefix));
+}
+
+__TMPL
+bool __CLS::writer_place(table* table_, entry& entry_) {
+    // When the probe run gets too long the entry that is left without a slot
+    // stays in entry_.
+    slot_view view = { table_ };
+    return probing::place(view, entry_, home(table_, entry_.level, entry_.prefix));
+}
+
+__TMPL
+void __CLS::writer_grow(const entry* homeless) {
+    // The new table is filled before it is published, readers keep probing
+    // the old one until they reload the pointer.
+    table *old_table = _table.load(std::memory_order_relaxed);
+    for(size_t capacity = (old_table->mask + 1) * 2;; capacity *= 2) {
+        table *new_table = allocate_table(capacity);
+        bool placed = true;
+        for(size_t i = 0; placed && i <= old_table->mask; i++) {
+            entry entry_ = load(old_table->slots[i]);
+            if(!entry_.distance)
+                continue;
+            placed = writer_place(new_table, entry_);
+        }
+        if(placed && homeless) {
+            entry entry_ = *homeless;
+            placed = writer_place(new_table, entry_);
+        }
+        if(placed) {
+            new_table->size = old_table->size;
+            _table.store(new_table, std::memory_order_release);
+            retire(old_table, free_table);
+            return;
+        }
+        free_table(this, new_table);
+    }
+}
+
+__TMPL
+void __CLS::writer_insert(int level, KeyT prefix, leaf* left, leaf* right) {
+    table *table_ = _table.load(std::memory_order_relaxed);
+    if((table_->size + 1) * 8 > (table_->mask + 1) * 7) {
+        writer_grow(NULL);
+        table_ = _table.load(std::memory_order_relaxed);
+    }
+    entry entry_ = { prefix, (unsigned char)level, 1, left, right };
+    if(!writer_place(table_, entry_)) {
+        writer_grow(&entry_);
+        table_ = _table.load(std::memory_order_relaxed);
+    }
+    table_->size++;
+}
+
+__TMPL
+void __CLS::writer_erase(int level, KeyT prefix) {
+    table *table_ = _table.load(std::memory_order_relaxed);
+    slot_view view = { table_ };
+    probing::remove(view, writer_find(level, prefix) - table_->slots);
+    table_->size--;
+}
+
+__TMPL
+__INNER::leaf* __CLS::writer_leaf(KeyT key) {
+    slot *node = writer_find(Width - 1, key >> 1);
+    if(!node)
+        return NULL;
+    leaf *candidate = (key & 1) == 1 ? node->right.load(std::memory_order_relaxed) : node->left.load(std::memory_order_relaxed);
+    return candidate->key == key ? candidate : NULL;
+}
+
+__TMPL
+__INNER::leaf* __CLS::writer_lower(KeyT key) {
+    // Nobody else writes, so the reader path can't be torn here.
+    leaf *found;
+    read_lower(key, _version.load(std::memory_order_relaxed), found);
+    return found;
+}
+
+__TMPL
+__INNER::leaf* __CLS::new_leaf(KeyT key, const ValueT& value) {
+    leaf *leaf_ = std::allocator_traits<leaf_allocator_t>::allocate(_leaf_allocator, 1);
+    ::new((void *)leaf_) leaf;
+    leaf_->left.store(leaf_, std::memory_order_relaxed);
+    leaf_->right.store(leaf_, std::memory_order_relaxed);
+    leaf_->key = key;
+    leaf_->value = value;
+    return leaf_;
+}
+
+__TMPL
+void __CLS::link_after(leaf* marker, leaf* new_leaf) {
+    leaf *head = _leaf_list.load(std::memory_order_relaxed);
+    if(!head) {
+        _leaf_list.store(new_leaf, std::memory_order_relaxed);
+        return;
+    }
+    if(!marker) {
+        marker = head->left.load(std::memory_order_relaxed);
+        _leaf_list.store(new_leaf, std::memory_order_relaxed);
+    }
+    leaf *right = marker->right.load(std::memory_order_relaxed);
+    new_leaf->left.store(marker, std::memory_order_relaxed);
+    new_leaf->right.store(right, std::memory_order_relaxed);
+    marker->right.store(new_leaf, std::memory_order_relaxed);
+    right->left.store(new_leaf, std::memory_order_relaxed);
+}
+
+__TMPL
+bool __CLS::insert(const KeyT& key, const ValueT& value) {
+    if(writer_leaf(key))
+        return false;
+    leaf *predecessor = writer_lower(key);
+    leaf *leaf_ = new_leaf(key, value);
+
+    write_begin();
+    link_after(predecessor, leaf_);
+    for(int i = Width - 1; i >= 0; i--) {
+        KeyT prefix = bits::prefix<KeyT, Width>(key, i);
+        slot *current = writer_find(i, prefix);
+        if(!current)
+            writer_insert(i, prefix, leaf_, leaf_);
+        else if(current->left.load(std::memory_order_relaxed)->key > key)
+            current->left.store(leaf_, std::memory_order_relaxed);
+        else if(current->right.load(std::memory_order_relaxed)->key < key)
+            current->right.store(leaf_, std::memory_order_relaxed);
+        else
+            break;
+    }
+    _count.store(_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    write_end();
+    return true;
+}
+
+__TMPL
+void __CLS::insert_or_assign(const KeyT& key, const ValueT& value) {
+    leaf *old_leaf = writer_leaf(key);
+    if(!old_leaf) {
+        insert(key, value);
+        return;
+    }
+    leaf *leaf_ = new_leaf(key, value);
+
+    // Readers may be copying the old value, so the leaf is replaced rather
+    // than written to.
+    write_begin();
+    leaf *left = old_leaf->left.load(std::memory_order_relaxed);
+    leaf *right = old_leaf->right.load(std::memory_order_relaxed);
+    if(left != old_leaf) {
+        leaf_->left.store(left, std::memory_order_relaxed);
+        leaf_->right.store(right, std::memory_order_relaxed);
+        left->right.store(leaf_, std::memory_order_relaxed);
+        right->left.store(leaf_, std::memory_order_relaxed);
+    }
+    if(_leaf_list.load(std::memory_order_relaxed) == old_leaf)
+        _leaf_list.store(leaf_, std::memory_order_relaxed);
+    for(int i = Width - 1; i >= 0; i--) {
+        slot *current = writer_find(i, bits::prefix<KeyT, Width>(key, i));
+        bool replaced = false;
+        if(current->left.load(std::memory_order_relaxed) == old_leaf) {
+            current->left.store(leaf_, std::memory_order_relaxed);
+            replaced = true;
+        }
+        if(current->right.load(std::memory_order_relaxed) == old_leaf) {
+            current->right.store(leaf_, std::memory_order_relaxed);
+            replaced = true;
+        }
+        if(!replaced)
+            break;
+    }
+    write_end();
+    retire(old_leaf, free_leaf);
+}
+
+__TMPL
+bool __CLS::erase(const KeyT& key) {
+    leaf *leaf_ = writer_leaf(key);
+    if(!leaf_)
+        return false;
+
+    write_begin();
+    leaf *left = leaf_->left.load(std::memory_order_relaxed);
+    leaf *right = leaf_->right.load(std::memory_order_relaxed);
+    if(right == leaf_)
+        _leaf_list.store(NULL, std::memory_order_relaxed);
+    else {
+        left->right.store(right, std::memory_order_relaxed);
+        right->left.store(left, std::memory_order_relaxed);
+        if(_leaf_list.load(std::memory_order_relaxed) == leaf_)
+            _leaf_list.store(right, std::memory_order_relaxed);
+    }
+    for(int i = Width - 1; i >= 0; i--) {
+        KeyT prefix = bits::prefix<KeyT, Width>(key, i);
+        slot *current = writer_find(i, prefix);
+        leaf *min = current->left.load(std::memory_order_relaxed);
+        leaf *max = current->right.load(std::memory_order_relaxed);
+        if(min == leaf_ && max == leaf_)
+            writer_erase(i, prefix);
+        else if(min == leaf_)
+            current->left.store(right, std::memory_order_relaxed);
+        else if(max == leaf_)
+            current->right.store(left, std::memory_order_relaxed);
+        else
+            break;
+    }
+    _count.store(_count.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+    write_end();
+    retire(leaf_, free_leaf);
+    return true;
+}
+
+#undef __INNER
+#undef __CLS
+#undef __TMPL
+#endif
@@ -0,0 +1,81 @@
+//
+//  epoch.h
+//
+//  Epoch-based memory reclamation for structures with lock-free readers.
+//  Author: Anil Anar.
+//
+
+#ifndef _epoch_h
+#define _epoch_h
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace kora {
+    // Readers pin the domain for the duration of a traversal; memory the
+    // writer unlinks is retired rather than freed and only handed to its
+    // deleter once every reader that was pinned at retirement has unpinned.
+    //
+    // Every thread takes one of MaxThreads reader slots on its first pin and
+    // gives it back when it exits. A thread must not pin a domain it already
+    // has pinned. retire() and reclaim() belong to a single writer thread.
+    template<int MaxThreads = 128>
+    class epoch_domain {
+    private:
+        struct alignas(64) reader {
+            std::atomic<uint64_t> epoch;    // 0 while not pinned
+        };
+        struct retired {
+            void* pointer;
+            void (*deleter)(void* context, void* pointer);
+            void* context;
+            uint64_t epoch;
+        };
+        struct slot_owner {
+            int index;
+            slot_owner();
+            ~slot_owner();
+        };
+
+        static std::atomic<bool> _taken[MaxThreads];
+
+        std::atomic<uint64_t> _epoch;
+        reader _readers[MaxThreads];
+        std::vector<retired> _retired;
+
+        epoch_domain(const epoch_domain&);
+        epoch_domain& operator=(const epoch_domain&);
+
+        static int thread_slot();
+        void unpin(int slot);
+
+    public:
+        class guard {
+        private:
+            friend class epoch_domain;
+            epoch_domain* _domain;
+            int _slot;
+            guard(epoch_domain* domain, int slot): _domain(domain), _slot(slot) {}
+            guard& operator=(const guard&);
+        public:
+            guard(guard&& other): _domain(other._domain), _slot(other._slot) { other._domain = NULL; }
+            ~guard() { if(_domain) _domain->unpin(_slot); }
+        };
+
+        epoch_domain();
+        ~epoch_domain();
+
+        guard pin();
+
+        void retire(void* pointer, void (*deleter)(void* context, void* pointer), void* context);
+        // Advances the epoch and frees what no pinned reader can still see.
+        void reclaim();
+        size_t pending() const;
+    };
+}
+
+#include "epoch_impl.h"
+
+#endif
@@ -0,0 +1,109 @@
+//
+//  epoch_impl.h
+//
+//  Epoch-based memory reclamation for structures with lock-free readers.
+//  Author: Anil Anar.
+//
+
+#ifndef _epoch_impl_h
+#define _epoch_impl_h
+
+#define __TMPL      template<int MaxThreads>
+#define __CLS       kora::epoch_domain<MaxThreads>
+
+#include <stdexcept>
+
+__TMPL
+std::atomic<bool> __CLS::_taken[MaxThreads];
+
+__TMPL
+__CLS::slot_owner::slot_owner():
+index(-1) {
+    for(int i = 0; i < MaxThreads; i++) {
+        bool expected = false;
+        if(!_taken[i].load(std::memory_order_relaxed) && _taken[i].compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            index = i;
+            return;
+        }
+    }
+}
+
+__TMPL
+__CLS::slot_owner::~slot_owner() {
+    if(index >= 0)
+        _taken[index].store(false, std::memory_order_release);
+}
+
+__TMPL
+int __CLS::thread_slot() {
+    static thread_local slot_owner owner;
+    if(owner.index < 0)
+        throw std::runtime_error("More threads than epoch_domain reader slots.");
+    return owner.index;
+}
+
+__TMPL
+__CLS::epoch_domain():
+_epoch(1) {
+    for(int i = 0; i < MaxThreads; i++) {
+        _readers[i].epoch.store(0, std::memory_order_relaxed);
+    }
+}
+
+__TMPL
+__CLS::~epoch_domain() {
+    for(size_t i = 0; i < _retired.size(); i++) {
+        _retired[i].deleter(_retired[i].context, _retired[i].pointer);
+    }
+}
+
+__TMPL
+typename __CLS::guard __CLS::pin() {
+    int slot = thread_slot();
+    _readers[slot].epoch.store(_epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    // Publishes the pin before any shared pointer is read.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return guard(this, slot);
+}
+
+__TMPL
+void __CLS::unpin(int slot) {
+    _readers[slot].epoch.store(0, std::memory_order_release);
+}
+
+__TMPL
+void __CLS::retire(void* pointer, void (*deleter)(void* context, void* pointer), void* context) {
+    retired entry = { pointer, deleter, context, _epoch.load(std::memory_order_relaxed) };
+    _retired.push_back(entry);
+}
+
+__TMPL
+void __CLS::reclaim() {
+    // Orders the unlinking of everything retired so far before the scan: a
+    // reader not seen pinned here can only pin afterwards and won't find it.
+    _epoch.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t oldest = UINT64_MAX;
+    for(int i = 0; i < MaxThreads; i++) {
+        uint64_t epoch = _readers[i].epoch.load(std::memory_order_acquire);
+        if(epoch && epoch < oldest)
+            oldest = epoch;
+    }
+    size_t kept = 0;
+    for(size_t i = 0; i < _retired.size(); i++) {
+        if(_retired[i].epoch < oldest)
+            _retired[i].deleter(_retired[i].context, _retired[i].pointer);
+        else
+            _retired[kept++] = _retired[i];
+    }
+    _retired.resize(kept);
+}
+
+__TMPL
+size_t __CLS::pending() const {
+    return _retired.size();
+}
+
+#undef __CLS
+#undef __TMPL
+#endif
@@ -0,0 +1,112 @@
+//
+//  concurrent_x_fast_trie.cpp
+//  fast-trie-unit-tests
+//
+//  Created by Anil Anar.
+//
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "concurrent_x_fast_trie.h"
+
+typedef kora::concurrent_x_fast_trie<unsigned int, 32, unsigned int> concurrent_trie;
+
+class concurrent_x_fast_trie: public testing::Test {
+};
+
+TEST_F(concurrent_x_fast_trie, RandomAgainstMap) {
+    concurrent_trie trie;
+    std::map<unsigned int, unsigned int> expected;
+    std::mt19937 random(4);
+    for(int i = 0; i < 20000; i++) {
+        unsigned int key = random() % 5000;
+        switch(random() % 3) {
+            case 0:
+                EXPECT_EQ(trie.erase(key), expected.erase(key) == 1);
+                break;
+            case 1:
+                trie.insert_or_assign(key, i);
+                expected[key] = i;
+                break;
+            default:
+                EXPECT_EQ(trie.insert(key, i), expected.insert({key, (unsigned int)i}).second);
+        }
+    }
+    EXPECT_EQ(trie.size(), expected.size());
+    
+    for(unsigned int key = 0; key < 5010; key++) {
+        unsigned int value;
+        auto it = expected.find(key);
+        EXPECT_EQ(trie.find(key, value), it != expected.end());
+        if(it != expected.end()) {
+            EXPECT_EQ(value, it->second);
+        }
+        
+        concurrent_trie::value_type found;
+        auto lower = expected.lower_bound(key);
+        EXPECT_EQ(trie.lower_bound(key, found), lower != expected.end());
+        if(lower != expected.end()) {
+            EXPECT_EQ(found, concurrent_trie::value_type(*lower));
+        }
+        EXPECT_EQ(trie.predecessor(key, found), lower != expected.begin());
+        if(lower != expected.begin()) {
+            EXPECT_EQ(found, concurrent_trie::value_type(*std::prev(lower)));
+        }
+        auto upper = expected.upper_bound(key);
+        EXPECT_EQ(trie.successor(key, found), upper != expected.end());
+        if(upper != expected.end()) {
+            EXPECT_EQ(found, concurrent_trie::value_type(*upper));
+        }
+    }
+}
+
+TEST_F(concurrent_x_fast_trie, ReadersDuringUpdates) {
+    // Multiples of 4 stay in the trie with their own key as value, the writer
+    // churns everything in between. Readers must never miss a stable key nor
+    // see a neighbour beyond one.
+    concurrent_trie trie;
+    const unsigned int range = 1 << 14;
+    for(unsigned int key = 0; key < range; key += 4)
+        trie.insert(key, key);
+    
+    std::atomic<bool> done(false);
+    std::atomic<size_t> failures(0);
+    std::vector<std::thread> readers;
+    for(int t = 0; t < 3; t++) {
+        readers.push_back(std::thread([&, t]() {
+            std::mt19937 random(t);
+            while(!done.load()) {
+                unsigned int key = random() % range;
+                unsigned int stable = key & ~3u;
+                unsigned int value;
+                concurrent_trie::value_type found;
+                if(!trie.find(stable, value) || value != stable)
+                    failures++;
+                if(stable + 4 < range && (!trie.lower_bound(key, found) || found.first < key || found.first > stable + 4))
+                    failures++;
+                if(key != stable && (!trie.predecessor(key, found) || found.first < stable || found.first >= key))
+                    failures++;
+            }
+        }));
+    }
+    
+    std::mt19937 random(100);
+    for(int i = 0; i < 200000; i++) {
+        unsigned int key = random() % range;
+        if(key % 4 == 0)
+            trie.insert_or_assign(key, key);
+        else if(random() % 2)
+            trie.insert(key, i);
+        else
+            trie.erase(key);
+    }
+    done = true;
+    for(auto& reader : readers)
+        reader.join();
+    EXPECT_EQ(failures.load(), 0u);
+}
@@ -0,0 +1,128 @@
+//
+//  sharded_x_fast_trie.cpp
+//  fast-trie-unit-tests
+//
+//  Created by Anil Anar.
+//
+
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "sharded_x_fast_trie.h"
+
+typedef kora::sharded_x_fast_trie<unsigned int, 16, int, 3> small_trie;
+
+class sharded_x_fast_trie: public testing::Test {
+};
+
+TEST_F(sharded_x_fast_trie, RandomAgainstMap) {
+    small_trie trie;
+    std::map<unsigned int, int> expected;
+    std::mt19937 random(9);
+    for(int i = 0; i < 20000; i++) {
+        unsigned int key = random() % 65536;
+        switch(random() % 4) {
+            case 0:
+                EXPECT_EQ(trie.erase(key), expected.erase(key) == 1);
+                break;
+            case 1:
+                trie.insert_or_assign(key, i);
+                expected[key] = i;
+                break;
+            default:
+                EXPECT_EQ(trie.insert(key, i), expected.insert({key, i}).second);
+        }
+    }
+    EXPECT_EQ(trie.size(), expected.size());
+    
+    for(unsigned int key = 0; key < 65536; key += 7) {
+        int value;
+        auto it = expected.find(key);
+        EXPECT_EQ(trie.find(key, value), it != expected.end());
+        if(it != expected.end()) {
+            EXPECT_EQ(value, it->second);
+        }
+        
+        small_trie::value_type neighbour;
+        auto lower = expected.lower_bound(key);
+        EXPECT_EQ(trie.predecessor(key, neighbour), lower != expected.begin());
+        if(lower != expected.begin()) {
+            EXPECT_EQ(neighbour.first, std::prev(lower)->first);
+        }
+        auto upper = expected.upper_bound(key);
+        EXPECT_EQ(trie.successor(key, neighbour), upper != expected.end());
+        if(upper != expected.end()) {
+            EXPECT_EQ(neighbour.first, upper->first);
+        }
+    }
+    
+    auto it = expected.begin();
+    trie.for_each([&](unsigned int key, int value) {
+        ASSERT_NE(it, expected.end());
+        EXPECT_EQ(key, it->first);
+        EXPECT_EQ(value, it->second);
+        ++it;
+    });
+    EXPECT_EQ(it, expected.end());
+}
+
+TEST_F(sharded_x_fast_trie, AcrossEmptyShards) {
+    small_trie trie;
+    small_trie::value_type neighbour;
+    EXPECT_FALSE(trie.predecessor(40000, neighbour));
+    trie.insert(0x0003, 3);
+    trie.insert(0xFFF0, 4);
+    EXPECT_TRUE(trie.predecessor(0x9000, neighbour));
+    EXPECT_EQ(neighbour.first, 0x0003);
+    EXPECT_TRUE(trie.successor(0x0003, neighbour));
+    EXPECT_EQ(neighbour.first, 0xFFF0);
+    EXPECT_EQ(neighbour.second, 4);
+    EXPECT_FALSE(trie.successor(0xFFF0, neighbour));
+    EXPECT_FALSE(trie.predecessor(0x0003, neighbour));
+    trie.insert(0x1FFF, 5);
+    EXPECT_TRUE(trie.predecessor(0x2000, neighbour));
+    EXPECT_EQ(neighbour.first, 0x1FFF);
+    trie.clear();
+    EXPECT_TRUE(trie.empty());
+}
+
+TEST_F(sharded_x_fast_trie, ConcurrentWriters) {
+    kora::sharded_x_fast_trie<unsigned int, 32, unsigned int, 4, std::allocator<std::pair<const unsigned int, unsigned int>>, kora::flat_levels> trie;
+    const int thread_count = 8;
+    const unsigned int per_thread = 5000;
+    std::vector<std::thread> threads;
+    for(int t = 0; t < thread_count; t++) {
+        threads.push_back(std::thread([&trie, t]() {
+            std::mt19937 random(t);
+            for(unsigned int i = 0; i < per_thread; i++) {
+                unsigned int key = (random() & ~7u) | t;
+                trie.insert_or_assign(key, key);
+                unsigned int found;
+                if(trie.find(key, found))
+                    EXPECT_EQ(found, key);
+                else
+                    ADD_FAILURE();
+                if(i % 3 == 0)
+                    trie.erase(key);
+            }
+        }));
+    }
+    for(auto& thread : threads)
+        thread.join();
+    
+    size_t count = 0;
+    unsigned int previous = 0;
+    trie.for_each([&](unsigned int key, unsigned int value) {
+        EXPECT_EQ(key, value);
+        if(count) {
+            EXPECT_LT(previous, key);
+        }
+        previous = key;
+        count++;
+    });
+    EXPECT_EQ(count, trie.size());
+    EXPECT_GT(count, 0u);
+}
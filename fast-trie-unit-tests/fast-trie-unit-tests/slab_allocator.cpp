@@ -0,0 +1,112 @@
+//
+//  slab_allocator.cpp
+//  fast-trie-unit-tests
+//
+//  Created by Anil Anar.
+//
+
+#include <gtest/gtest.h>
+#include <string>
+#include <map>
+#include <random>
+
+#include "slab_allocator.h"
+#include "x_fast_trie.h"
+
+namespace {
+    int live_values = 0;
+
+    struct counted {
+        int value;
+        counted(): value(0) { live_values++; }
+        counted(const counted& other): value(other.value) { live_values++; }
+        ~counted() { live_values--; }
+    };
+}
+
+class slab_allocator: public testing::Test {
+};
+
+TEST_F(slab_allocator, RecyclesFreedSlots) {
+    kora::slab_allocator<long> allocator;
+    long *first = allocator.allocate(1);
+    long *second = allocator.allocate(1);
+    EXPECT_NE(first, second);
+    allocator.deallocate(first, 1);
+    EXPECT_EQ(allocator.allocate(1), first);
+    EXPECT_EQ(allocator.reserved_bytes(), 64 * 1024);
+
+    kora::slab_allocator<char>::rebind<long>::other copy(allocator);
+    EXPECT_TRUE(copy == allocator);
+    EXPECT_FALSE(kora::slab_allocator<long>() == allocator);
+
+    allocator.release();
+    EXPECT_EQ(allocator.reserved_bytes(), 0);
+}
+
+TEST_F(slab_allocator, TrieAgainstMap) {
+    typedef std::pair<const unsigned int, std::string> value_type;
+    kora::x_fast_trie<unsigned int, 32, std::string, kora::slab_allocator<value_type>> trie;
+    std::map<unsigned int, std::string> expected;
+    std::mt19937 random(3);
+    for(int round = 0; round < 2; round++) {
+        for(int i = 0; i < 5000; i++) {
+            unsigned int key = random() % 3000;
+            if(random() % 3) {
+                bool inserted = expected.insert({key, std::to_string(key)}).second;
+                EXPECT_EQ(trie.insert({key, std::to_string(key)}).second, inserted);
+            } else if(expected.erase(key)) {
+                trie.erase(trie.find(key));
+            }
+        }
+        EXPECT_EQ(trie.size(), expected.size());
+        for(auto &p : expected) {
+            EXPECT_EQ(trie.at(p.first), p.second);
+        }
+        trie.clear();
+        expected.clear();
+        EXPECT_TRUE(trie.empty());
+    }
+}
+
+TEST_F(slab_allocator, ClearDestroysValues) {
+    typedef std::pair<const unsigned int, counted> value_type;
+    {
+        kora::x_fast_trie<unsigned int, 32, counted, kora::slab_allocator<value_type>> trie;
+        for(unsigned int i = 0; i < 100; i++)
+            trie.insert({i * 7, counted()});
+        EXPECT_EQ(live_values, 100);
+        trie.clear();
+        EXPECT_EQ(live_values, 0);
+        for(unsigned int i = 0; i < 10; i++)
+            trie.insert({i, counted()});
+        EXPECT_EQ(live_values, 10);
+    }
+    EXPECT_EQ(live_values, 0);
+}
+
+TEST_F(slab_allocator, OversizedChunksReserved) {
+    kora::slab_arena<256> arena;
+    arena.allocate(1000);
+    EXPECT_GE(arena.reserved_bytes(), 1000u);
+    size_t oversized = arena.reserved_bytes();
+    arena.allocate(16);
+    EXPECT_EQ(arena.reserved_bytes(), oversized + 256);
+    arena.release();
+    EXPECT_EQ(arena.reserved_bytes(), 0u);
+}
+
+TEST_F(slab_allocator, LevelsShareOneArena) {
+    typedef std::pair<const unsigned int, int> value_type;
+    kora::x_fast_trie<unsigned int, 32, int, kora::slab_allocator<value_type>> trie;
+    trie.insert({12345, 1});
+
+    // Every level holds one node, all of them in a single chunk.
+    kora::trie_memory memory = trie.memory_usage();
+    size_t level_bytes = memory.shared_table_bytes;
+    for(size_t i = 0; i < memory.levels.size(); i++) {
+        EXPECT_EQ(memory.levels[i].entries, 1u);
+        level_bytes += memory.levels[i].node_bytes;
+    }
+    EXPECT_EQ(level_bytes, 64u * 1024);
+}
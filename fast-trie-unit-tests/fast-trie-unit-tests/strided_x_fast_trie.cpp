@@ -0,0 +1,97 @@
+//
+//  strided_x_fast_trie.cpp
+//  fast-trie-unit-tests
+//
+//  Created by Anil Anar.
+//
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+
+#include "strided_x_fast_trie.h"
+#include "x_fast_trie.h"
+#include "trie_test_helpers.h"
+
+class strided_x_fast_trie: public testing::Test {
+};
+
+TEST_F(strided_x_fast_trie, MatchesMap) {
+    typedef std::allocator<std::pair<const unsigned int, int>> allocator32_t;
+    typedef std::allocator<std::pair<const uint64_t, int>> allocator64_t;
+    for(unsigned int seed = 0; seed < 3; seed++) {
+        uint64_t dense = 3000;
+        trie_test::compare_with_map<kora::strided_x_fast_trie<unsigned int, 32, int, 1>, unsigned int>(seed, dense, 4000);
+        trie_test::compare_with_map<kora::strided_x_fast_trie<unsigned int, 32, int, 2>, unsigned int>(seed, dense, 4000);
+        trie_test::compare_with_map<kora::strided_x_fast_trie<unsigned int, 32, int, 3>, unsigned int>(seed, dense, 4000);
+        trie_test::compare_with_map<kora::strided_x_fast_trie<unsigned int, 32, int, 4>, unsigned int>(seed, dense, 4000);
+        trie_test::compare_with_map<kora::strided_x_fast_trie<unsigned int, 32, int, 8>, unsigned int>(seed, dense, 4000);
+        trie_test::compare_with_map<kora::strided_x_fast_trie<unsigned int, 32, int, 4, allocator32_t, kora::flat_levels>, unsigned int>(seed, dense, 4000);
+        trie_test::compare_with_map<kora::strided_x_fast_trie<unsigned int, 32, int, 8>, unsigned int>(seed, 0xFFFFFFFFull, 4000);
+        trie_test::compare_with_map<kora::strided_x_fast_trie<unsigned int, 20, int, 8>, unsigned int>(seed, 1 << 20, 4000);
+        trie_test::compare_with_map<kora::strided_x_fast_trie<unsigned int, 12, int, 7>, unsigned int>(seed, 1 << 12, 4000);
+        trie_test::compare_with_map<kora::strided_x_fast_trie<uint64_t, 64, int, 4>, uint64_t>(seed, ~0ull, 4000);
+        trie_test::compare_with_map<kora::strided_x_fast_trie<uint64_t, 64, int, 8, allocator64_t, kora::flat_levels>, uint64_t>(seed, ~0ull, 4000);
+        trie_test::compare_with_map<kora::strided_x_fast_trie<uint64_t, 64, int, 6>, uint64_t>(seed, 1 << 16, 4000);
+    }
+}
+
+TEST_F(strided_x_fast_trie, Basics) {
+    kora::strided_x_fast_trie<unsigned int, 32, std::string, 4> trie;
+    EXPECT_TRUE(trie.empty());
+    EXPECT_EQ(trie.begin(), trie.end());
+    EXPECT_EQ(trie.lower_bound(5), trie.end());
+    EXPECT_EQ(trie.predecessor(5), trie.end());
+    trie.insert({{10, "10"}, {20, "20"}, {0xFFFFFFFF, "max"}, {0, "min"}});
+    EXPECT_EQ(trie.size(), 4u);
+    EXPECT_EQ(trie.at(20), "20");
+    EXPECT_THROW(trie.at(21), std::out_of_range);
+    trie[21] = "21";
+    EXPECT_EQ(trie.at(21), "21");
+    EXPECT_EQ(trie.successor(21)->first, 0xFFFFFFFFu);
+    EXPECT_EQ(trie.successor(0xFFFFFFFF), trie.end());
+    EXPECT_EQ(trie.predecessor(0), trie.end());
+    auto it = trie.erase(trie.find(10));
+    EXPECT_EQ(it->first, 20u);
+    trie.clear();
+    EXPECT_TRUE(trie.empty());
+    EXPECT_EQ(trie.find(20), trie.end());
+    trie.insert({7, "7"});
+    EXPECT_EQ(trie.cbegin()->first, 7u);
+}
+
+TEST_F(strided_x_fast_trie, FewerEntriesAndProbes) {
+    typedef std::allocator<std::pair<const uint64_t, int>> allocator_t;
+    kora::x_fast_trie<uint64_t, 64, int, allocator_t, kora::hashed_levels, kora::counting_stats> plain;
+    kora::strided_x_fast_trie<uint64_t, 64, int, 8, allocator_t, kora::hashed_levels, kora::counting_stats> strided;
+    std::mt19937_64 random(5);
+    std::vector<uint64_t> keys;
+    for(int i = 0; i < 1000; i++) {
+        keys.push_back(random());
+        plain.insert({keys.back(), i});
+        strided.insert({keys.back(), i});
+    }
+
+    // One entry per key and level kept, eight levels of 64.
+    kora::trie_memory memory = strided.memory_usage();
+    ASSERT_EQ(memory.levels.size(), 8u);
+    EXPECT_EQ(memory.levels[7].entries, 1000u);
+    EXPECT_LT(memory.total() * 2, plain.memory_usage().total());
+
+    plain.reset_stats();
+    strided.reset_stats();
+    for(size_t i = 0; i < keys.size(); i++) {
+        EXPECT_EQ(plain.lower_bound(keys[i] + 1) == plain.end(), strided.lower_bound(keys[i] + 1) == strided.end());
+    }
+    EXPECT_LT(strided.stats().lookup.level_searches, plain.stats().lookup.level_searches);
+
+    // The last key frees its leaf and a node at each of the eight levels.
+    strided.clear();
+    strided.insert({keys[0], 0});
+    strided.reset_stats();
+    strided.erase(keys[0]);
+    EXPECT_EQ(strided.stats().erase.frees, 1u + 8);
+}
@@ -0,0 +1,79 @@
+//
+//  trie_test_helpers.h
+//  fast-trie-unit-tests
+//
+//  Created by Anil Anar.
+//
+
+#ifndef _trie_test_helpers_h
+#define _trie_test_helpers_h
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <random>
+
+namespace trie_test {
+    // Runs random inserts, erases and queries against std::map, keys drawn
+    // from [0, range).
+    template<class Trie, class KeyT>
+    void compare_with_map(unsigned int seed, uint64_t range, int operations) {
+        std::mt19937_64 random(seed);
+        Trie trie;
+        std::map<KeyT, int> expected;
+        for(int i = 0; i < operations; i++) {
+            KeyT key = (KeyT)(random() % range);
+            int op = random() % 4;
+            if(op < 2) {
+                bool inserted = expected.insert({key, i}).second;
+                auto result = trie.insert({key, i});
+                ASSERT_EQ(result.second, inserted);
+                ASSERT_EQ(result.first->first, key);
+            } else if(op == 2) {
+                ASSERT_EQ(trie.erase(key), expected.erase(key));
+            } else {
+                auto found = trie.find(key);
+                auto it = expected.find(key);
+                if(it == expected.end())
+                    ASSERT_EQ(found, trie.end());
+                else
+                    ASSERT_EQ(found->second, it->second);
+            }
+
+            auto lower = trie.lower_bound(key);
+            auto expected_lower = expected.lower_bound(key);
+            if(expected_lower == expected.end())
+                ASSERT_EQ(lower, trie.end());
+            else
+                ASSERT_EQ(lower->first, expected_lower->first);
+            auto upper = trie.upper_bound(key);
+            auto expected_upper = expected.upper_bound(key);
+            if(expected_upper == expected.end())
+                ASSERT_EQ(upper, trie.end());
+            else
+                ASSERT_EQ(upper->first, expected_upper->first);
+            auto below = trie.predecessor(key);
+            if(expected_lower == expected.begin())
+                ASSERT_EQ(below, trie.end());
+            else
+                ASSERT_EQ(below->first, std::prev(expected_lower)->first);
+            ASSERT_EQ(trie.size(), expected.size());
+        }
+
+        auto it = trie.begin();
+        for(auto& entry : expected) {
+            ASSERT_EQ(it->first, entry.first);
+            ++it;
+        }
+        ASSERT_EQ(it, trie.end());
+        while(!expected.empty()) {
+            ASSERT_EQ(trie.erase(expected.begin()->first), 1u);
+            expected.erase(expected.begin());
+        }
+        ASSERT_TRUE(trie.empty());
+        ASSERT_EQ(trie.memory_usage().levels[0].entries, 0u);
+    }
+}
+
+#endif
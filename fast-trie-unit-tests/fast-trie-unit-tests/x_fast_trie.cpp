@@ -9,54 +9,65 @@
 #include <gtest/gtest.h>
 #include <string>
 #include <unordered_set>
+#include <unordered_map>
+#include <stdexcept>
+#include <iterator>
 #include <vector>
 #include <set>
 #include <map>
 #include <algorithm>
+#include <random>
+#include <memory>
+#include <tuple>
 
 #define private protected
 
 #include "x_fast_trie.h"
 
-template<class KeyT, int Width, class ValueT, class Allocator = std::allocator<std::pair<const KeyT, ValueT>>>
+template<class KeyT, int Width, class ValueT, class Allocator = std::allocator<std::pair<const KeyT, ValueT>>, class Levels = kora::hashed_levels>
 
-class x_fast_trie_test: public kora::x_fast_trie<KeyT, Width, ValueT, Allocator> {
+class x_fast_trie_test: public kora::x_fast_trie<KeyT, Width, ValueT, Allocator, Levels> {
 private:
-    typedef kora::x_fast_trie<unsigned int, 32, std::string> super;
+    typedef kora::x_fast_trie<KeyT, Width, ValueT, Allocator, Levels> super;
 public:
     void verify() {
-        std::unordered_set<KeyT> levels[Width];
+        std::unordered_map<KeyT, std::pair<KeyT, KeyT>> levels[Width];
         std::set<KeyT> nodes;
-        for(super::iterator it = super::begin(); it != super::end(); it++)
+        for(typename super::iterator it = super::begin(); it != super::end(); it++)
             nodes.insert(it->first);
         
-        super:: x_fast_node *temp;
+        typename super::x_fast_node *temp;
         for(auto node : nodes) {
-            for(int i = 0; i < super::_width; i++) {
-                KeyT id_ = node >> (super::_width - 1 - i) >> 1;
-                super::lookup_t &lookup = super::_table[i];
-                super::lookup_t::iterator temp_it = lookup.find(id_);
-                if(temp_it == lookup.end())
+            for(int i = 0; i < Width; i++) {
+                KeyT id_ = node >> (Width - 1 - i) >> 1;
+                temp = super::_table.find(i, id_);
+                if(!temp)
                     throw std::exception();
-                temp = &((*temp_it).second);
-                if(temp->left->is_leaf() && !nodes.count(dynamic_cast<super::x_leaf_node *>(temp->left)->key()))
+                if(!nodes.count(temp->left->key()) || !nodes.count(temp->right->key()))
                     throw std::exception();
-                if(temp->right->is_leaf() && !nodes.count(dynamic_cast<super::x_leaf_node *>(temp->right)->key()))
+                if(temp->left->key() > node || temp->right->key() < node)
                     throw std::exception();
-                if(i == super::_width - 1 && (!(temp->left->is_leaf()) || !(temp->right->is_leaf())))
-                    throw std::exception();
-                levels[i].insert(id_);
+                if(!levels[i].count(id_))
+                    levels[i][id_].first = node;
+                levels[i][id_].second = node;
             }
         }
-        for(int i = 0; i < super::_width; i++) {
-            if(super::_table[i].size() != levels[i].size())
+        for(int i = 0; i < Width; i++) {
+            if(super::_table.size(i) != levels[i].size())
                 throw std::exception();
+            for(auto bounds : levels[i]) {
+                temp = super::_table.find(i, bounds.first);
+                if(temp->left->key() != bounds.second.first || temp->right->key() != bounds.second.second)
+                    throw std::exception();
+            }
         }
     }
 };
 
 typedef std::pair<const unsigned int, std::string> value_type;
 typedef x_fast_trie_test<unsigned int, 32, std::string> trie_type;
+typedef x_fast_trie_test<unsigned int, 32, std::string, std::allocator<value_type>, kora::flat_levels> flat_trie_type;
+typedef x_fast_trie_test<unsigned int, 16, std::string, std::allocator<value_type>, kora::dense_levels> dense_trie_type;
 
 bool cmp(const value_type &a, const value_type &b) {
     return a.first < b.first;
@@ -154,6 +165,40 @@ TEST_F(x_fast_trie, Deletion) {
     EXPECT_THROW(trie.at(763), std::out_of_range);
 }
 
+TEST_F(x_fast_trie, DeletionByKey) {
+    x_fast_trie_test<unsigned int, 32, std::string> trie;
+    EXPECT_EQ(trie.erase(5), 0u);
+    for(unsigned int key : {5u, 9u, 1000u, 0u, 0xFFFFFFFFu})
+        trie.insert({key, std::to_string(key)});
+    EXPECT_EQ(trie.erase(9), 1u);
+    EXPECT_NO_THROW(trie.verify());
+    EXPECT_EQ(trie.erase(9), 0u);
+    EXPECT_EQ(trie.erase(10), 0u);
+    EXPECT_EQ(trie.size(), 4u);
+    EXPECT_EQ(trie.find(9), trie.end());
+    EXPECT_EQ(trie.erase(0), 1u);
+    EXPECT_EQ(trie.erase(0xFFFFFFFFu), 1u);
+    EXPECT_NO_THROW(trie.verify());
+    EXPECT_EQ(trie.begin()->first, 5u);
+    EXPECT_EQ(trie.erase(5), 1u);
+    EXPECT_EQ(trie.erase(1000), 1u);
+    EXPECT_TRUE(trie.empty());
+    EXPECT_EQ(trie.begin(), trie.end());
+}
+
+TEST_F(x_fast_trie, DeletionReturnsNext) {
+    x_fast_trie_test<unsigned int, 32, std::string> trie;
+    for(unsigned int key : {5u, 9u, 1000u})
+        trie.insert({key, std::to_string(key)});
+    auto it = trie.erase(trie.find(5));
+    ASSERT_NE(it, trie.end());
+    EXPECT_EQ(it->first, 9u);
+    EXPECT_EQ(trie.erase(trie.find(1000)), trie.end());
+    EXPECT_NO_THROW(trie.verify());
+    EXPECT_EQ(trie.erase(trie.find(9)), trie.end());
+    EXPECT_TRUE(trie.empty());
+}
+
 TEST_F(x_fast_trie, Iteration) {
     x_fast_trie_test<unsigned int, 32, std::string> trie;
     EXPECT_EQ(trie.begin(), trie.end());
@@ -173,10 +218,854 @@ TEST_F(x_fast_trie, Iteration) {
     
     std::sort(pairs, pairs + 8, cmp);
     
-    int i = 0;
+    size_t i = 0;
     for(auto it = trie.begin(); i < trie.size(); it++, i++) {
         EXPECT_EQ(it->first, pairs[i].first);
     }
+    
+    auto it = trie.rbegin();
+    for(i = 8; i > 0; i--, it--) {
+        ASSERT_NE(it, trie.rend());
+        EXPECT_EQ(it->first, pairs[i - 1].first);
+    }
+    EXPECT_EQ(it, trie.rend());
+    EXPECT_EQ(trie.rcbegin()->first, 913);
+    trie.clear();
+    EXPECT_EQ(trie.rcbegin(), trie.rcend());
+}
+
+
+
+TEST_F(x_fast_trie, FlatLevels) {
+    flat_trie_type trie;
+    std::map<unsigned int, std::string> expected;
+    std::mt19937 random(7);
+    for(int i = 0; i < 5000; i++) {
+        unsigned int key = random() % 2000;
+        if(random() % 3) {
+            bool inserted = expected.insert({key, std::to_string(key)}).second;
+            EXPECT_EQ(trie.insert({key, std::to_string(key)}).second, inserted);
+        } else if(expected.erase(key)) {
+            trie.erase(trie.find(key));
+        }
+    }
+    EXPECT_NO_THROW(trie.verify());
+    EXPECT_EQ(trie.size(), expected.size());
+    for(unsigned int key = 0; key < 2000; key++) {
+        EXPECT_EQ(trie.find(key) != trie.end(), expected.count(key) == 1);
+    }
+}
+
+TEST_F(x_fast_trie, DenseLevels) {
+    dense_trie_type trie;
+    std::map<unsigned int, std::string> expected;
+    std::mt19937 random(7);
+    for(int i = 0; i < 20000; i++) {
+        unsigned int key = random() % (i < 10000 ? 3000 : 65536);
+        if(random() % 3) {
+            bool inserted = expected.insert({key, std::to_string(key)}).second;
+            EXPECT_EQ(trie.insert({key, std::to_string(key)}).second, inserted);
+        } else if(expected.erase(key)) {
+            trie.erase(trie.find(key));
+        }
+    }
+    EXPECT_NO_THROW(trie.verify());
+    EXPECT_EQ(trie.size(), expected.size());
+    for(unsigned int key = 0; key < 65536; key++) {
+        auto it = expected.lower_bound(key);
+        auto found = trie.lower_bound(key);
+        if(it == expected.end())
+            ASSERT_EQ(found, trie.end());
+        else
+            ASSERT_EQ(found->first, it->first);
+    }
+    
+    std::set<unsigned int> pairs;
+    for(auto& entry : expected)
+        pairs.insert(entry.first >> 1);
+    kora::trie_memory memory = trie.memory_usage();
+    EXPECT_EQ(memory.levels[15].entries, pairs.size());
+    EXPECT_EQ(memory.levels[0].entries, 1u);
+    trie.clear();
+    EXPECT_EQ(trie.memory_usage().levels[15].entries, 0u);
+    EXPECT_EQ(trie.find(expected.begin()->first), trie.end());
+    trie.insert({0xFFFF, "max"});
+    EXPECT_NO_THROW(trie.verify());
+    
+    // Small widths pick the dense table unless told otherwise.
+    EXPECT_TRUE((std::is_same<kora::default_levels<16>::type, kora::dense_levels>::value));
+    EXPECT_TRUE((std::is_same<kora::default_levels<17>::type, kora::hashed_levels>::value));
+    kora::x_fast_trie<unsigned int, 8, int> byte_trie;
+    for(unsigned int key = 0; key < 256; key += 3)
+        byte_trie.insert({key, (int)key});
+    EXPECT_EQ(byte_trie.lower_bound(100)->first, 102u);
+    EXPECT_EQ(byte_trie.predecessor(0), byte_trie.end());
+    EXPECT_EQ(byte_trie.memory_usage().levels[7].entries, 86u);
+}
+
+TEST_F(x_fast_trie, DirectTopLevels) {
+    x_fast_trie_test<unsigned int, 32, std::string, std::allocator<value_type>, kora::direct_top_levels<>> trie;
+    x_fast_trie_test<unsigned int, 32, std::string, std::allocator<value_type>, kora::direct_top_levels<8, kora::flat_levels>> flat;
+    trie_type hashed;
+    std::map<unsigned int, std::string> expected;
+    std::mt19937 random(11);
+    for(int i = 0; i < 8000; i++) {
+        unsigned int key = i < 4000 ? random() % 3000 : random();
+        if(random() % 3) {
+            bool inserted = expected.insert({key, std::to_string(key)}).second;
+            EXPECT_EQ(trie.insert({key, std::to_string(key)}).second, inserted);
+            flat.insert({key, std::to_string(key)});
+            hashed.insert({key, std::to_string(key)});
+        } else if(expected.erase(key)) {
+            trie.erase(trie.find(key));
+            flat.erase(key);
+            hashed.erase(key);
+        }
+    }
+    EXPECT_NO_THROW(trie.verify());
+    EXPECT_NO_THROW(flat.verify());
+    EXPECT_EQ(trie.size(), expected.size());
+    for(int i = 0; i < 5000; i++) {
+        unsigned int key = i < 2500 ? random() % 3000 : random();
+        auto it = expected.lower_bound(key);
+        if(it == expected.end()) {
+            ASSERT_EQ(trie.lower_bound(key), trie.end());
+            ASSERT_EQ(flat.lower_bound(key), flat.end());
+        } else {
+            ASSERT_EQ(trie.lower_bound(key)->first, it->first);
+            ASSERT_EQ(flat.lower_bound(key)->first, it->first);
+        }
+    }
+    
+    kora::trie_memory memory = trie.memory_usage();
+    kora::trie_memory hashed_memory = hashed.memory_usage();
+    for(int i = 0; i < 32; i++) {
+        EXPECT_EQ(memory.levels[i].entries, hashed_memory.levels[i].entries);
+        EXPECT_EQ(flat.memory_usage().levels[i].entries, hashed_memory.levels[i].entries);
+    }
+    EXPECT_EQ(memory.levels[15].buckets, 0u);
+    EXPECT_GT(memory.levels[16].buckets, 0u);
+    EXPECT_GT(memory.shared_table_bytes, 0u);
+    trie.clear();
+    EXPECT_EQ(trie.memory_usage().levels[3].entries, 0u);
+    EXPECT_EQ(trie.memory_usage().levels[31].entries, 0u);
+    trie.insert({5, "5"});
+    EXPECT_NO_THROW(trie.verify());
+}
+
+TEST_F(x_fast_trie, LevelHashKernels) {
+    std::vector<kora::bits::level_hash_kernel> kernels = { kora::bits::level_hashes_scalar };
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        kernels.push_back(kora::bits::level_hashes_avx2);
+    if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq"))
+        kernels.push_back(kora::bits::level_hashes_avx512);
+#endif
+    std::mt19937_64 random(3);
+    uint64_t hashes[65];
+    for(int width = 1; width <= 64; width++) {
+        uint64_t key = width < 64 ? random() >> (64 - width) : random();
+        for(int from = 0; from <= width; from += 3) {
+            for(auto kernel : kernels) {
+                std::fill(hashes, hashes + 65, 0);
+                kernel(key, width, from, width, hashes);
+                for(int level = from; level < width; level++) {
+                    uint64_t prefix = key >> (width - 1 - level) >> 1;
+                    ASSERT_EQ(hashes[level - from], kora::bits::level_hash(level, prefix));
+                }
+                ASSERT_EQ(hashes[width - from], 0u);
+            }
+        }
+    }
+    kora::bits::level_hashes(5, 32, 30, 32, hashes);
+    EXPECT_EQ(hashes[1], kora::bits::level_hash(31, 2));
+}
+
+TEST_F(x_fast_trie, BuildSorted) {
+    std::mt19937 random(11);
+    std::map<unsigned int, std::string> expected;
+    for(int i = 0; i < 3000; i++) {
+        unsigned int key = random() % 4 ? random() % 5000 : random();
+        expected.insert({key, std::to_string(key)});
+    }
+    std::vector<std::pair<unsigned int, std::string>> sorted(expected.begin(), expected.end());
+    
+    trie_type trie;
+    trie.insert({1, "stale"});
+    trie.build_sorted(sorted.begin(), sorted.end());
+    EXPECT_NO_THROW(trie.verify());
+    EXPECT_EQ(trie.size(), expected.size());
+    auto it = trie.begin();
+    for(auto pair : expected) {
+        EXPECT_EQ(it->first, pair.first);
+        EXPECT_EQ(it->second, pair.second);
+        it++;
+    }
+    EXPECT_EQ(it, trie.end());
+    
+    flat_trie_type flat;
+    flat.build_sorted(expected.begin(), expected.end());
+    EXPECT_NO_THROW(flat.verify());
+    EXPECT_EQ(flat.size(), expected.size());
+    
+    kora::x_fast_trie<unsigned int, 32, std::string> constructed(kora::sorted_unique, expected.begin(), expected.end());
+    EXPECT_EQ(constructed.size(), expected.size());
+    EXPECT_EQ(constructed.at(expected.rbegin()->first), expected.rbegin()->second);
+    
+    // The built trie must keep working like an inserted one.
+    for(int i = 0; i < 2000; i++) {
+        unsigned int key = random() % 5000;
+        if(random() % 2) {
+            bool inserted = expected.insert({key, std::to_string(key)}).second;
+            EXPECT_EQ(trie.insert({key, std::to_string(key)}).second, inserted);
+        } else if(expected.erase(key)) {
+            trie.erase(trie.find(key));
+        }
+    }
+    EXPECT_NO_THROW(trie.verify());
+    EXPECT_EQ(trie.size(), expected.size());
+}
+
+TEST_F(x_fast_trie, BuildSortedInput) {
+    trie_type trie;
+    std::vector<std::pair<unsigned int, std::string>> repeated = {{1, "a"}, {1, "b"}, {4, "c"}, {4, "d"}};
+    trie.build_sorted(repeated.begin(), repeated.end());
+    EXPECT_NO_THROW(trie.verify());
+    EXPECT_EQ(trie.size(), 2);
+    EXPECT_EQ(trie.at(1), "a");
+    EXPECT_EQ(trie.at(4), "c");
+    
+    std::vector<std::pair<unsigned int, std::string>> unsorted = {{1, "a"}, {7, "b"}, {3, "c"}};
+    EXPECT_THROW(trie.build_sorted(unsorted.begin(), unsorted.end()), std::invalid_argument);
+    EXPECT_TRUE(trie.empty());
+    EXPECT_NO_THROW(trie.verify());
+    
+    trie.build_sorted(repeated.end(), repeated.end());
+    EXPECT_TRUE(trie.empty());
+    
+    std::vector<std::pair<unsigned int, std::string>> moved = {{2, "2"}, {5, "5"}, {9, "9"}};
+    trie.build_sorted(std::make_move_iterator(moved.begin()), std::make_move_iterator(moved.end()));
+    EXPECT_NO_THROW(trie.verify());
+    EXPECT_EQ(trie.size(), 3);
+}
+
+TEST_F(x_fast_trie, BatchedLookups) {
+    std::mt19937 random(5);
+    std::map<unsigned int, std::string> expected;
+    trie_type trie;
+    flat_trie_type flat;
+    for(int i = 0; i < 1000; i++) {
+        unsigned int key = random() % 100000;
+        expected.insert({key, std::to_string(key)});
+        trie.insert({key, std::to_string(key)});
+        flat.insert({key, std::to_string(key)});
+    }
+    std::vector<unsigned int> keys;
+    for(int i = 0; i < 777; i++)
+        keys.push_back(random() % 2 ? random() % 100010 : std::next(expected.begin(), random() % expected.size())->first);
+    keys.push_back(0);
+    keys.push_back(expected.rbegin()->first);
+    keys.push_back(~0u);
+    
+    std::vector<trie_type::iterator> found, bounds;
+    trie.find_many(keys.data(), keys.size(), std::back_inserter(found));
+    trie.lower_bound_many(keys.data(), keys.size(), std::back_inserter(bounds));
+    std::vector<flat_trie_type::iterator> flat_found, flat_bounds;
+    flat.find_many(keys.data(), keys.size(), std::back_inserter(flat_found));
+    flat.lower_bound_many(keys.data(), keys.size(), std::back_inserter(flat_bounds));
+    ASSERT_EQ(found.size(), keys.size());
+    ASSERT_EQ(bounds.size(), keys.size());
+    
+    for(size_t i = 0; i < keys.size(); i++) {
+        EXPECT_EQ(found[i], trie.find(keys[i]));
+        EXPECT_EQ(flat_found[i], flat.find(keys[i]));
+        auto bound = expected.lower_bound(keys[i]);
+        if(bound == expected.end()) {
+            EXPECT_EQ(bounds[i], trie.end());
+            EXPECT_EQ(flat_bounds[i], flat.end());
+        } else {
+            ASSERT_NE(bounds[i], trie.end());
+            EXPECT_EQ(bounds[i]->first, bound->first);
+            ASSERT_NE(flat_bounds[i], flat.end());
+            EXPECT_EQ(flat_bounds[i]->first, bound->first);
+        }
+    }
+    
+    trie_type empty;
+    empty.lower_bound_many(keys.data(), 3, bounds.begin());
+    EXPECT_EQ(bounds[0], empty.end());
+}
+
+TEST_F(x_fast_trie, OrderedQueries) {
+    std::mt19937 random(3);
+    std::map<unsigned int, std::string> expected;
+    flat_trie_type trie;
+    const flat_trie_type &const_trie = trie;
+    EXPECT_EQ(trie.lower_bound(5), trie.end());
+    EXPECT_EQ(trie.predecessor(5), trie.end());
+    for(int i = 0; i < 500; i++) {
+        unsigned int key = random() % 3000;
+        expected.insert({key, std::to_string(key)});
+        trie.insert({key, std::to_string(key)});
+    }
+    
+    for(unsigned int key = 0; key < 3010; key++) {
+        auto lower = expected.lower_bound(key);
+        auto upper = expected.upper_bound(key);
+        auto it = trie.lower_bound(key);
+        auto const_it = const_trie.lower_bound(key);
+        if(lower == expected.end()) {
+            EXPECT_EQ(it, trie.end());
+            EXPECT_EQ(const_it, const_trie.cend());
+        } else {
+            ASSERT_NE(it, trie.end());
+            EXPECT_EQ(it->first, lower->first);
+            EXPECT_EQ(const_it->first, lower->first);
+        }
+        
+        it = trie.upper_bound(key);
+        EXPECT_EQ(it, trie.successor(key));
+        EXPECT_EQ(const_trie.upper_bound(key), it);
+        if(upper == expected.end())
+            EXPECT_EQ(it, trie.end());
+        else
+            EXPECT_EQ(it->first, upper->first);
+        
+        it = trie.predecessor(key);
+        EXPECT_EQ(const_trie.predecessor(key), it);
+        if(lower == expected.begin())
+            EXPECT_EQ(it, trie.end());
+        else
+            EXPECT_EQ(it->first, std::prev(lower)->first);
+        
+        auto range = const_trie.equal_range(key);
+        EXPECT_EQ(range.first, const_trie.lower_bound(key));
+        EXPECT_EQ(range.second, const_trie.upper_bound(key));
+        EXPECT_EQ(trie.equal_range(key).first, range.first);
+    }
+    
+    EXPECT_EQ(const_trie.at(expected.begin()->first), expected.begin()->second);
+    EXPECT_EQ(const_trie.find(3001), const_trie.cend());
+    auto it = trie.begin();
+    auto previous = it++;
+    EXPECT_EQ(previous, trie.begin());
+    EXPECT_EQ(it->first, std::next(expected.begin())->first);
+}
+
+TEST_F(x_fast_trie, Stats) {
+    typedef kora::x_fast_trie<unsigned int, 32, int, std::allocator<std::pair<const unsigned int, int>>, kora::hashed_levels, kora::counting_stats> counted_trie;
+    counted_trie trie;
+    
+    // An empty trie misses the parent prefix and every level the search
+    // tries, then the new leaf gets a prefix node at every level without
+    // looking any of them up.
+    trie.insert({7, 1});
+    kora::trie_stats stats = trie.stats();
+    EXPECT_EQ(stats.insert.calls, 1u);
+    EXPECT_EQ(stats.insert.allocations, 1u + 32);
+    EXPECT_EQ(stats.insert.level_searches, 6u);
+    EXPECT_EQ(stats.insert.hash_probes, 1u + 6 + 32);
+    EXPECT_EQ(stats.lookup.calls, 0u);
+    
+    trie.reset_stats();
+    EXPECT_NE(trie.find(7), trie.end());
+    EXPECT_EQ(trie.find(8), trie.end());
+    stats = trie.stats();
+    EXPECT_EQ(stats.lookup.calls, 2u);
+    EXPECT_EQ(stats.lookup.hash_probes, 2u);
+    EXPECT_EQ(stats.insert.calls, 0u);
+    
+    trie.reset_stats();
+    trie[9] = 2;
+    trie.predecessor(9);
+    stats = trie.stats();
+    EXPECT_EQ(stats.lookup.calls, 1u);
+    // 9 shares 28 bits with 7, levels 29 to 31 are new.
+    EXPECT_EQ(stats.insert.calls, 1u);
+    EXPECT_EQ(stats.insert.allocations, 1u + 3);
+    EXPECT_GT(stats.lookup.level_searches, 0u);
+    
+    trie.reset_stats();
+    trie.erase(trie.find(9));
+    stats = trie.stats();
+    EXPECT_EQ(stats.erase.calls, 1u);
+    EXPECT_EQ(stats.erase.frees, 1u + 3);
+    EXPECT_GT(stats.erase.hash_probes, 0u);
+    
+    // The last key takes a node at every level with it.
+    trie.reset_stats();
+    trie.erase(7);
+    EXPECT_EQ(trie.stats().erase.frees, 1u + 32);
+    
+    // Levels 0 to 29 hold one node, 30 two and 31 three.
+    trie.insert({1, 0});
+    trie.insert({2, 0});
+    trie.insert({7, 0});
+    trie.reset_stats();
+    trie.clear();
+    EXPECT_EQ(trie.stats().erase.frees, 3u + 30 + 2 + 3);
+    
+    // Building over old keys drops them without counting an erase.
+    trie.insert({5, 0});
+    trie.reset_stats();
+    std::vector<std::pair<unsigned int, int>> sorted = {{1, 0}, {2, 0}};
+    trie.build_sorted(sorted.begin(), sorted.end());
+    stats = trie.stats();
+    EXPECT_EQ(stats.erase.calls, 0u);
+    EXPECT_EQ(stats.erase.frees, 0u);
+    EXPECT_EQ(stats.insert.allocations, 2u + 31 + 2);
+    
+    trie_type plain;
+    plain.insert({1, "1"});
+    EXPECT_EQ(plain.stats().insert.calls, 0u);
+}
+
+TEST_F(x_fast_trie, MemoryUsage) {
+    trie_type hashed;
+    flat_trie_type flat;
+    EXPECT_EQ(hashed.memory_usage().leaf_bytes, 0u);
+    EXPECT_EQ(flat.memory_usage().bytes_per_key(), 0);
+    for(unsigned int key = 0; key < 1000; key++) {
+        hashed.insert({key * 7919, "x"});
+        flat.insert({key * 7919, "x"});
+    }
+    
+    kora::trie_memory hashed_memory = hashed.memory_usage();
+    kora::trie_memory flat_memory = flat.memory_usage();
+    ASSERT_EQ(hashed_memory.levels.size(), 32u);
+    ASSERT_EQ(flat_memory.levels.size(), 32u);
+    EXPECT_EQ(hashed_memory.leaf_count, 1000u);
+    EXPECT_GT(hashed_memory.leaf_bytes, 1000 * sizeof(value_type));
+    EXPECT_GT(hashed_memory.allocator_overhead, 0u);
+    EXPECT_EQ(hashed_memory.shared_table_bytes, 0u);
+    EXPECT_GT(flat_memory.shared_table_bytes, 0u);
+    for(int i = 0; i < 32; i++) {
+        EXPECT_EQ(flat_memory.levels[i].entries, hashed_memory.levels[i].entries);
+        EXPECT_GE(hashed_memory.levels[i].buckets, hashed_memory.levels[i].entries);
+        EXPECT_EQ(flat_memory.levels[i].buckets, 0u);
+    }
+    EXPECT_EQ(hashed_memory.levels[0].entries, 1u);
+    EXPECT_EQ(hashed_memory.levels[31].entries, 1000u);
+    EXPECT_GT(hashed_memory.total(), hashed_memory.leaf_bytes + hashed_memory.levels[31].node_bytes);
+    EXPECT_GT(hashed_memory.bytes_per_key(), 0);
+    
+    typedef kora::slab_allocator<std::pair<const unsigned int, int>> slab_t;
+    kora::x_fast_trie<unsigned int, 32, int, slab_t> slab_trie;
+    for(unsigned int key = 0; key < 1000; key++)
+        slab_trie.insert({key, 0});
+    kora::trie_memory slab_memory = slab_trie.memory_usage();
+    EXPECT_EQ(slab_memory.leaf_bytes + slab_memory.allocator_overhead, 64u * 1024);
+    
+    hashed.clear();
+    EXPECT_EQ(hashed.memory_usage().levels[31].entries, 0u);
+}
+
+TEST_F(x_fast_trie, Emplace) {
+    typedef kora::x_fast_trie<unsigned int, 32, std::unique_ptr<int>> move_only_trie;
+    move_only_trie trie;
+    
+    auto result = trie.try_emplace(5, new int(50));
+    EXPECT_TRUE(result.second);
+    EXPECT_EQ(*result.first->second, 50);
+    std::unique_ptr<int> kept(new int(51));
+    result = trie.try_emplace(5, std::move(kept));
+    EXPECT_FALSE(result.second);
+    EXPECT_EQ(*result.first->second, 50);
+    EXPECT_NE(kept, nullptr);
+    
+    result = trie.emplace(std::piecewise_construct, std::forward_as_tuple(9), std::forward_as_tuple(new int(90)));
+    EXPECT_TRUE(result.second);
+    result = trie.emplace(9u, std::unique_ptr<int>(new int(91)));
+    EXPECT_FALSE(result.second);
+    EXPECT_EQ(*result.first->second, 90);
+    
+    result = trie.insert_or_assign(9, std::unique_ptr<int>(new int(92)));
+    EXPECT_FALSE(result.second);
+    EXPECT_EQ(*trie.at(9), 92);
+    result = trie.insert_or_assign(1, std::move(kept));
+    EXPECT_TRUE(result.second);
+    EXPECT_EQ(*trie.at(1), 51);
+    
+    result = trie.insert(std::make_pair(3u, std::unique_ptr<int>(new int(30))));
+    EXPECT_TRUE(result.second);
+    EXPECT_EQ(trie[7], nullptr);
+    trie[7].reset(new int(70));
+    unsigned int moved = 11;
+    result = trie.try_emplace(std::move(moved), new int(110));
+    EXPECT_TRUE(result.second);
+    moved = 11;
+    result = trie.try_emplace(std::move(moved), std::move(kept));
+    EXPECT_FALSE(result.second);
+    moved = 13;
+    EXPECT_EQ(trie[std::move(moved)], nullptr);
+    trie.erase(13);
+    trie.erase(11);
+    
+    std::vector<unsigned int> keys;
+    for(auto it = trie.begin(); it != trie.end(); ++it)
+        keys.push_back(it->first);
+    EXPECT_EQ(keys, std::vector<unsigned int>({ 1, 3, 5, 7, 9 }));
+    EXPECT_EQ(*trie.at(7), 70);
+    
+    trie_type strings;
+    for(unsigned int key = 0; key < 200; key++)
+        strings[key * 13] = std::to_string(key);
+    for(unsigned int key = 0; key < 200; key++)
+        strings.try_emplace(key * 7, "seven");
+    strings.verify();
+    EXPECT_EQ(strings.at(13), "1");
+    EXPECT_EQ(strings.at(14), "seven");
+    EXPECT_EQ(strings.at(91), "7");
+}
+
+TEST_F(x_fast_trie, HintedInsert) {
+    std::mt19937 random(5);
+    std::map<unsigned int, std::string> expected;
+    trie_type trie;
+    flat_trie_type flat;
+    
+    // Mostly ascending keys, each hinted with the last inserted element,
+    // with the odd random key and a random hint thrown in.
+    auto last = trie.end();
+    auto flat_last = flat.end();
+    unsigned int key = 1000;
+    for(int i = 0; i < 2000; i++) {
+        unsigned int next = i % 50 == 0 ? random() % 100000 : key + random() % 8 - 2;
+        key = next;
+        std::string value = std::to_string(key);
+        expected.insert({key, value});
+        auto hint = i % 37 == 0 ? trie.find(std::next(expected.begin(), random() % expected.size())->first) : last;
+        last = trie.insert(hint, {key, value});
+        EXPECT_EQ(last->first, key);
+        flat_last = flat.emplace_hint(flat_last, key, value);
+        EXPECT_EQ(flat_last->first, key);
+    }
+    trie.verify();
+    flat.verify();
+    ASSERT_EQ(trie.size(), expected.size());
+    ASSERT_EQ(flat.size(), expected.size());
+    auto it = trie.begin();
+    auto flat_it = flat.begin();
+    for(auto pair : expected) {
+        EXPECT_EQ(it->first, pair.first);
+        EXPECT_EQ(it->second, pair.second);
+        EXPECT_EQ(flat_it->first, pair.first);
+        ++it;
+        ++flat_it;
+    }
+    
+    // A hint holding the key keeps the old value.
+    auto existing = trie.find(expected.begin()->first);
+    EXPECT_EQ(trie.insert(existing, {existing->first, "new"}), existing);
+    EXPECT_EQ(existing->second, expected.begin()->second);
+    auto inserted = trie.try_emplace(trie.end(), 100001, "max");
+    EXPECT_EQ(inserted, trie.find(100001));
+    inserted = trie.try_emplace(trie.begin(), 0, "min");
+    EXPECT_EQ(inserted, trie.begin());
+    trie.verify();
+    
+    typedef kora::x_fast_trie<unsigned int, 32, int, std::allocator<std::pair<const unsigned int, int>>, kora::hashed_levels, kora::counting_stats> counted_trie;
+    counted_trie plain;
+    counted_trie hinted;
+    std::vector<counted_trie::iterator> hints;
+    for(unsigned int k = 0; k < 1000; k++) {
+        plain.insert({k * 4, 0});
+        hints.push_back(hinted.insert({k * 4, 0}).first);
+    }
+    plain.reset_stats();
+    hinted.reset_stats();
+    for(unsigned int k = 0; k < 1000; k++) {
+        plain.insert({k * 4 + 2, 0});
+        hinted.insert(hints[k], {k * 4 + 2, 0});
+    }
+    EXPECT_EQ(hinted.stats().insert.level_searches, 0u);
+    EXPECT_LT(hinted.stats().insert.hash_probes, plain.stats().insert.hash_probes);
 }
 
+TEST_F(x_fast_trie, Append) {
+    typedef kora::x_fast_trie<unsigned int, 32, int, std::allocator<std::pair<const unsigned int, int>>, kora::hashed_levels, kora::counting_stats> counted_trie;
+    std::mt19937 random(6);
+    trie_type trie;
+    counted_trie counted;
+    unsigned int key = 100;
+    for(int i = 0; i < 1000; i++) {
+        key += 1 + random() % 100;
+        auto it = trie.append(key, std::to_string(key));
+        EXPECT_EQ(it->first, key);
+        counted.insert({key, i});
+    }
+    EXPECT_EQ(counted.stats().insert.level_searches, 6u);
+    trie.verify();
+    EXPECT_EQ(trie.size(), 1000u);
+    EXPECT_THROW(trie.append(key, "again"), std::invalid_argument);
+    EXPECT_THROW(trie.append(key - 1, "lower"), std::invalid_argument);
+    EXPECT_EQ(trie.size(), 1000u);
+    
+    // New minimums take the shortcut as well.
+    for(unsigned int k = 0; k < 10; k++) {
+        counted.insert({10 - k, 0});
+    }
+    EXPECT_EQ(counted.stats().insert.level_searches, 6u);
+    EXPECT_EQ(counted.begin()->first, 1u);
+    
+    std::vector<unsigned int> keys;
+    for(auto it = trie.begin(); it != trie.end(); ++it)
+        keys.push_back(it->first);
+    EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+    trie.insert({key / 2, "middle"});
+    trie.verify();
+}
 
+TEST_F(x_fast_trie, RangeErase) {
+    std::mt19937 random(7);
+    for(int round = 0; round < 40; round++) {
+        std::map<unsigned int, std::string> expected;
+        trie_type trie;
+        flat_trie_type flat;
+        for(int i = 0; i < 300; i++) {
+            unsigned int key = round % 2 ? random() : random() % 2000;
+            expected.insert({key, "x"});
+            trie.insert({key, "x"});
+            flat.insert({key, "x"});
+        }
+        
+        while(!expected.empty()) {
+            unsigned int from = std::next(expected.begin(), random() % expected.size())->first;
+            unsigned int to = std::next(expected.begin(), random() % expected.size())->first;
+            if(to < from)
+                std::swap(from, to);
+            auto it = trie.erase(trie.find(from), trie.find(to));
+            flat.erase(flat.find(from), flat.find(to));
+            expected.erase(expected.find(from), expected.find(to));
+            EXPECT_EQ(it, trie.find(to));
+            trie.verify();
+            flat.verify();
+            ASSERT_EQ(trie.size(), expected.size());
+            ASSERT_EQ(flat.size(), expected.size());
+            auto trie_it = trie.begin();
+            for(auto pair : expected) {
+                ASSERT_EQ(trie_it->first, pair.first);
+                ++trie_it;
+            }
+            EXPECT_EQ(trie_it, trie.end());
+            if(from == to) {
+                trie.erase(trie.find(from), trie.end());
+                flat.erase(flat.find(from), flat.end());
+                expected.erase(expected.find(from), expected.end());
+            }
+        }
+        EXPECT_TRUE(trie.empty());
+        EXPECT_EQ(trie.begin(), trie.end());
+        trie.verify();
+    }
+}
+
+TEST_F(x_fast_trie, EraseBelowAbove) {
+    std::mt19937 random(8);
+    std::set<unsigned int> expected;
+    trie_type trie;
+    for(int i = 0; i < 2000; i++) {
+        unsigned int key = random() % 100000;
+        expected.insert(key);
+        trie.insert({key, "x"});
+    }
+    
+    size_t erased = trie.erase_below(20000);
+    EXPECT_EQ(erased, (size_t)std::distance(expected.begin(), expected.lower_bound(20000)));
+    expected.erase(expected.begin(), expected.lower_bound(20000));
+    trie.verify();
+    
+    erased = trie.erase_above(80000);
+    EXPECT_EQ(erased, (size_t)std::distance(expected.upper_bound(80000), expected.end()));
+    expected.erase(expected.upper_bound(80000), expected.end());
+    trie.verify();
+    
+    EXPECT_EQ(trie.erase_below(20000), 0u);
+    EXPECT_EQ(trie.erase_above(80000), 0u);
+    ASSERT_EQ(trie.size(), expected.size());
+    EXPECT_EQ(trie.begin()->first, *expected.begin());
+    EXPECT_EQ(trie.predecessor(*expected.begin()), trie.end());
+    EXPECT_EQ(trie.lower_bound(80001), trie.end());
+    
+    EXPECT_EQ(trie.erase_above(0), expected.size() - (expected.count(0)));
+    EXPECT_TRUE(trie.empty());
+    trie.verify();
+    trie.insert({5, "5"});
+    EXPECT_EQ(trie.erase_below(6), 1u);
+    EXPECT_TRUE(trie.empty());
+}
+
+TEST_F(x_fast_trie, InsertSortedBatch) {
+    std::mt19937 random(9);
+    for(int round = 0; round < 30; round++) {
+        std::map<unsigned int, std::string> expected;
+        trie_type trie;
+        flat_trie_type flat;
+        unsigned int range = round % 3 == 0 ? 500 : round % 3 == 1 ? 100000 : 0xFFFFFFFF;
+        for(int i = 0; i < round * 10; i++) {
+            unsigned int key = random() % range;
+            expected.insert({key, "old"});
+            trie.insert({key, "old"});
+            flat.insert({key, "old"});
+        }
+        
+        typedef std::pair<unsigned int, std::string> pair_type;
+        std::vector<pair_type> batch;
+        for(int i = 0; i < 400; i++) {
+            unsigned int key = random() % range;
+            batch.push_back({key, "new"});
+            if(i % 5 == 0)
+                batch.push_back({key, "repeat"});
+        }
+        std::stable_sort(batch.begin(), batch.end(), [](const pair_type& a, const pair_type& b) {
+            return a.first < b.first;
+        });
+        size_t before = expected.size();
+        for(auto pair : batch)
+            expected.insert(pair);
+        
+        EXPECT_EQ(trie.insert_sorted_batch(batch.begin(), batch.end()), expected.size() - before);
+        flat.insert_sorted_batch(batch.begin(), batch.end());
+        trie.verify();
+        flat.verify();
+        ASSERT_EQ(trie.size(), expected.size());
+        ASSERT_EQ(flat.size(), expected.size());
+        auto it = trie.begin();
+        for(auto pair : expected) {
+            EXPECT_EQ(it->first, pair.first);
+            EXPECT_EQ(it->second, pair.second);
+            EXPECT_EQ(flat.at(pair.first), pair.second);
+            ++it;
+        }
+        EXPECT_EQ(trie.insert_sorted_batch(batch.begin(), batch.end()), 0u);
+    }
+    
+    trie_type trie;
+    trie.insert({10, "10"});
+    std::vector<value_type> unsorted = { { 5, "5" }, { 20, "20" }, { 15, "15" } };
+    EXPECT_THROW(trie.insert_sorted_batch(unsorted.begin(), unsorted.end()), std::invalid_argument);
+    EXPECT_EQ(trie.size(), 1u);
+    trie.verify();
+    EXPECT_EQ(trie.insert_sorted_batch(unsorted.begin(), unsorted.begin()), 0u);
+}
+
+TEST_F(x_fast_trie, EraseSortedBatch) {
+    std::mt19937 random(10);
+    for(int round = 0; round < 30; round++) {
+        std::set<unsigned int> expected;
+        trie_type trie;
+        flat_trie_type flat;
+        unsigned int range = round % 3 == 0 ? 600 : round % 3 == 1 ? 100000 : 0xFFFFFFFF;
+        for(int i = 0; i < 500; i++) {
+            unsigned int key = random() % range;
+            expected.insert(key);
+            trie.insert({key, "x"});
+            flat.insert({key, "x"});
+        }
+        
+        while(!expected.empty()) {
+            std::vector<unsigned int> keys;
+            for(auto key : expected) {
+                if(random() % 3 == 0)
+                    keys.push_back(key);
+                if(random() % 10 == 0)
+                    keys.push_back(key);
+            }
+            for(int i = 0; i < 5; i++)
+                keys.push_back(random() % range);
+            std::sort(keys.begin(), keys.end());
+            size_t erased = 0;
+            for(size_t i = 0; i < keys.size(); i++) {
+                if(i && keys[i] == keys[i - 1])
+                    continue;
+                erased += expected.erase(keys[i]);
+            }
+            
+            EXPECT_EQ(trie.erase_sorted_batch(keys.begin(), keys.end()), erased);
+            flat.erase_sorted_batch(keys.begin(), keys.end());
+            trie.verify();
+            flat.verify();
+            ASSERT_EQ(trie.size(), expected.size());
+            ASSERT_EQ(flat.size(), expected.size());
+            auto it = trie.begin();
+            for(auto key : expected) {
+                ASSERT_EQ(it->first, key);
+                ++it;
+            }
+            EXPECT_EQ(it, trie.end());
+            if(expected.size() < 20) {
+                std::vector<unsigned int> rest(expected.begin(), expected.end());
+                EXPECT_EQ(trie.erase_sorted_batch(rest.begin(), rest.end()), rest.size());
+                flat.erase_sorted_batch(rest.begin(), rest.end());
+                expected.clear();
+            }
+        }
+        EXPECT_TRUE(trie.empty());
+        EXPECT_TRUE(flat.empty());
+        trie.verify();
+    }
+    
+    trie_type trie;
+    trie.insert({10, "10"});
+    trie.insert({20, "20"});
+    std::vector<unsigned int> unsorted = { 20, 10 };
+    EXPECT_THROW(trie.erase_sorted_batch(unsorted.begin(), unsorted.end()), std::invalid_argument);
+    EXPECT_EQ(trie.size(), 2u);
+    EXPECT_EQ(trie.erase_sorted_batch(unsorted.begin(), unsorted.begin()), 0u);
+}
+
+TEST_F(x_fast_trie, FingerLowerBound) {
+    std::mt19937 random(11);
+    for(int round = 0; round < 6; round++) {
+        trie_type trie;
+        flat_trie_type flat;
+        unsigned int range = round % 2 == 0 ? 5000 : 0xFFFFFFFF;
+        for(int i = 0; i < 2000; i++) {
+            unsigned int key = random() % range;
+            trie.insert({key, "x"});
+            flat.insert({key, "x"});
+        }
+        std::vector<trie_type::const_iterator> hints;
+        for(auto it = trie.cbegin(); it != trie.cend(); ++it)
+            hints.push_back(it);
+        hints.push_back(trie.cend());
+        
+        for(int i = 0; i < 5000; i++) {
+            trie_type::const_iterator hint = hints[random() % hints.size()];
+            unsigned int key = random() % range;
+            if(i % 2 && hint != trie.cend())
+                key = hint->first + random() % 64 - 32;
+            trie_type::iterator expected = trie.lower_bound(key);
+            ASSERT_EQ(trie.lower_bound(hint, key), expected);
+            flat_trie_type::const_iterator flat_hint = flat.cend();
+            if(hint != trie.cend())
+                flat_hint = flat.find(hint->first);
+            flat_trie_type::iterator found = flat.lower_bound(flat_hint, key);
+            if(expected == trie.end())
+                ASSERT_EQ(found, flat.end());
+            else
+                ASSERT_EQ(found->first, expected->first);
+        }
+    }
+    
+    trie_type empty;
+    EXPECT_EQ(empty.lower_bound(empty.cend(), 5), empty.end());
+    
+    // A hint next to the answer needs no probe, one farther away fewer than
+    // a search from the root.
+    typedef kora::x_fast_trie<unsigned int, 32, int, std::allocator<std::pair<const unsigned int, int>>, kora::hashed_levels, kora::counting_stats> counted_trie;
+    counted_trie counted;
+    for(unsigned int key = 0; key < 1 << 16; key += 4)
+        counted.insert({key << 8, 0});
+    counted_trie::iterator hint = counted.find(1000 << 8);
+    counted.reset_stats();
+    EXPECT_EQ(counted.lower_bound(hint, (1000 << 8) + 1)->first, 1004u << 8);
+    EXPECT_EQ(counted.stats().lookup.hash_probes, 0u);
+    counted.reset_stats();
+    EXPECT_EQ(counted.lower_bound(hint, (1100 << 8) + 1)->first, 1104u << 8);
+    uint64_t hinted = counted.stats().lookup.hash_probes;
+    counted.reset_stats();
+    EXPECT_EQ(counted.lower_bound((1100 << 8) + 1)->first, 1104u << 8);
+    EXPECT_LT(hinted, counted.stats().lookup.hash_probes);
+}
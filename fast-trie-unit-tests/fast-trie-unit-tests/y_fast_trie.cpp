@@ -0,0 +1,209 @@
+//
+//  y_fast_trie.cpp
+//  fast-trie-unit-tests
+//
+//  Created by Anil Anar.
+//
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+#include <memory>
+
+#define private protected
+
+#include "y_fast_trie.h"
+
+template<class KeyT, int Width, class ValueT>
+class y_fast_trie_test: public kora::y_fast_trie<KeyT, Width, ValueT> {
+private:
+    typedef kora::y_fast_trie<KeyT, Width, ValueT> super;
+public:
+    void verify() {
+        size_t total = 0;
+        bool first = true;
+        KeyT previous_max = 0;
+        for(typename super::bucket_iterator it = super::_index.begin(); it != super::_index.end(); ++it) {
+            typename super::bucket_t &bucket = it->second;
+            if(bucket.empty() || bucket.size() > super::max_bucket_size)
+                throw std::exception();
+            if(bucket.size() < super::min_bucket_size && super::_index.size() > 1)
+                throw std::exception();
+            if(bucket.begin()->first < it->first)
+                throw std::exception();
+            if(!first && it->first <= previous_max)
+                throw std::exception();
+            previous_max = bucket.rbegin()->first;
+            first = false;
+            total += bucket.size();
+        }
+        if(total != super::size())
+            throw std::exception();
+    }
+};
+
+typedef y_fast_trie_test<unsigned int, 32, std::string> y_trie_type;
+
+class y_fast_trie: public testing::Test {
+};
+
+TEST_F(y_fast_trie, AddMultiple) {
+    y_trie_type trie;
+    EXPECT_TRUE(trie.insert({1, "1"}).second);
+    EXPECT_FALSE(trie.insert({1, "1"}).second);
+    trie.insert({31, "31"});
+    trie.insert({0, "0"});
+    trie.insert({27, "27"});
+    EXPECT_NO_THROW(trie.verify());
+    EXPECT_EQ(trie.size(), 4);
+    EXPECT_EQ(trie[0], "0");
+    EXPECT_EQ(trie[1], "1");
+    EXPECT_EQ(trie[27], "27");
+    EXPECT_EQ(trie[31], "31");
+    EXPECT_THROW(trie.at(2), std::out_of_range);
+}
+
+TEST_F(y_fast_trie, LowerUpperBound) {
+    y_trie_type trie;
+    EXPECT_EQ(trie.lower_bound(5), trie.end());
+    for(unsigned int i = 10; i < 1000; i += 10)
+        trie.insert({i, std::to_string(i)});
+    EXPECT_EQ(trie.lower_bound(0)->first, 10);
+    EXPECT_EQ(trie.lower_bound(10)->first, 10);
+    EXPECT_EQ(trie.upper_bound(10)->first, 20);
+    EXPECT_EQ(trie.lower_bound(655)->first, 660);
+    EXPECT_EQ(trie.upper_bound(990), trie.end());
+    auto range = trie.equal_range(500);
+    EXPECT_EQ(range.first->first, 500);
+    EXPECT_EQ(range.second->first, 510);
+}
+
+TEST_F(y_fast_trie, RandomAgainstMap) {
+    y_trie_type trie;
+    std::map<unsigned int, std::string> expected;
+    std::mt19937 random(42);
+    std::uniform_int_distribution<unsigned int> keys(0, 5000);
+    for(int i = 0; i < 20000; i++) {
+        unsigned int key = keys(random);
+        if(random() % 3) {
+            bool inserted = expected.insert({key, std::to_string(key)}).second;
+            EXPECT_EQ(trie.insert({key, std::to_string(key)}).second, inserted);
+        } else {
+            EXPECT_EQ(trie.erase(key), expected.erase(key));
+        }
+        if(i % 1000 == 0) {
+            EXPECT_NO_THROW(trie.verify());
+        }
+    }
+    EXPECT_NO_THROW(trie.verify());
+    EXPECT_EQ(trie.size(), expected.size());
+
+    auto it = trie.begin();
+    for(auto &p : expected) {
+        ASSERT_NE(it, trie.end());
+        EXPECT_EQ(it->first, p.first);
+        EXPECT_EQ(it->second, p.second);
+        ++it;
+    }
+    EXPECT_EQ(it, trie.end());
+
+    for(auto p = expected.rbegin(); p != expected.rend(); ++p) {
+        --it;
+        EXPECT_EQ(it->first, p->first);
+    }
+
+    for(unsigned int key = 0; key < 5100; key += 7) {
+        auto lower = expected.lower_bound(key);
+        auto found = trie.lower_bound(key);
+        if(lower == expected.end()) {
+            EXPECT_EQ(found, trie.end());
+        } else {
+            EXPECT_EQ(found->first, lower->first);
+        }
+    }
+}
+
+TEST_F(y_fast_trie, EraseRange) {
+    y_trie_type trie;
+    for(unsigned int i = 0; i < 500; i++)
+        trie.insert({i * 3, std::to_string(i)});
+    auto last = trie.erase(trie.find(30), trie.find(900));
+    EXPECT_EQ(last->first, 900);
+    EXPECT_EQ(trie.size(), 500 - 290);
+    EXPECT_EQ(trie.find(600), trie.end());
+    EXPECT_NO_THROW(trie.verify());
+    trie.clear();
+    EXPECT_TRUE(trie.empty());
+    EXPECT_EQ(trie.begin(), trie.end());
+}
+
+TEST_F(y_fast_trie, PredecessorSuccessor) {
+    y_trie_type trie;
+    std::map<unsigned int, std::string> expected;
+    std::mt19937 random(9);
+    for(int i = 0; i < 2000; i++) {
+        unsigned int key = random() % 10000;
+        trie.insert({key, "x"});
+        expected.insert({key, "x"});
+    }
+    const y_trie_type& view = trie;
+    for(unsigned int key = 0; key < 10100; key += 3) {
+        auto above = expected.upper_bound(key);
+        auto below = expected.lower_bound(key);
+        if(above == expected.end()) {
+            ASSERT_EQ(trie.successor(key), trie.end());
+            ASSERT_EQ(view.successor(key), view.cend());
+        } else {
+            ASSERT_EQ(trie.successor(key)->first, above->first);
+            ASSERT_EQ(view.successor(key)->first, above->first);
+        }
+        if(below == expected.begin()) {
+            ASSERT_EQ(trie.predecessor(key), trie.end());
+            ASSERT_EQ(view.predecessor(key), view.cend());
+        } else {
+            ASSERT_EQ(trie.predecessor(key)->first, std::prev(below)->first);
+            ASSERT_EQ(view.predecessor(key)->first, std::prev(below)->first);
+        }
+        auto found = view.find(key);
+        ASSERT_EQ(found != view.cend(), expected.count(key) == 1);
+    }
+    auto last = view.cend();
+    --last;
+    EXPECT_EQ(last->first, expected.rbegin()->first);
+}
+
+TEST_F(y_fast_trie, MoveOnlyValues) {
+    // Splits and merges move the values between buckets.
+    kora::y_fast_trie<unsigned int, 32, std::unique_ptr<int>> trie;
+    for(unsigned int key = 0; key < 500; key++) {
+        EXPECT_TRUE(trie.try_emplace(key, new int(key)).second);
+    }
+    EXPECT_FALSE(trie.try_emplace(7, new int(0)).second);
+    trie[1000].reset(new int(1000));
+    for(unsigned int key = 0; key < 500; key += 2)
+        trie.erase(key);
+    EXPECT_EQ(trie.size(), 251u);
+    for(unsigned int key = 1; key < 500; key += 2)
+        EXPECT_EQ(*trie.at(key), (int)key);
+    EXPECT_EQ(*trie.at(1000), 1000);
+    EXPECT_EQ(trie[2], nullptr);
+}
+
+TEST_F(y_fast_trie, SmallWidthMemory) {
+    // The representatives stay in hashed levels at small widths too, so the
+    // footprint follows the number of keys rather than 2^Width.
+    kora::y_fast_trie<unsigned int, 20, int> trie;
+    for(unsigned int key = 0; key < 100; key++)
+        trie.insert({key * 10007 % (1 << 20), 0});
+    kora::trie_memory small = trie.memory_usage();
+    EXPECT_EQ(small.leaf_count, 100u);
+    EXPECT_LT(small.total(), 100u * 1024);
+    for(unsigned int key = 100; key < 1000; key++)
+        trie.insert({key * 10007 % (1 << 20), 0});
+    kora::trie_memory large = trie.memory_usage();
+    EXPECT_EQ(large.leaf_count, 1000u);
+    EXPECT_LT(large.total(), small.total() * 20);
+    EXPECT_LT(large.bytes_per_key(), 400);
+}
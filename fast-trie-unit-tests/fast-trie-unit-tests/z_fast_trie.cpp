@@ -0,0 +1,95 @@
+//
+//  z_fast_trie.cpp
+//  fast-trie-unit-tests
+//
+//  Created by Anil Anar.
+//
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+
+#include "z_fast_trie.h"
+#include "x_fast_trie.h"
+#include "trie_test_helpers.h"
+
+class z_fast_trie: public testing::Test {
+};
+
+TEST_F(z_fast_trie, MatchesMap) {
+    typedef std::allocator<std::pair<const unsigned int, int>> allocator32_t;
+    typedef std::allocator<std::pair<const uint64_t, int>> allocator64_t;
+    for(unsigned int seed = 0; seed < 3; seed++) {
+        trie_test::compare_with_map<kora::z_fast_trie<unsigned int, 32, int>, unsigned int>(seed, 3000, 4000);
+        trie_test::compare_with_map<kora::z_fast_trie<unsigned int, 32, int>, unsigned int>(seed, 0xFFFFFFFFull, 4000);
+        trie_test::compare_with_map<kora::z_fast_trie<unsigned int, 32, int, allocator32_t, kora::flat_levels>, unsigned int>(seed, 3000, 4000);
+        trie_test::compare_with_map<kora::z_fast_trie<unsigned int, 20, int>, unsigned int>(seed, 1 << 20, 4000);
+        trie_test::compare_with_map<kora::z_fast_trie<unsigned int, 16, int, allocator32_t, kora::dense_levels>, unsigned int>(seed, 1 << 16, 4000);
+        trie_test::compare_with_map<kora::z_fast_trie<unsigned int, 5, int>, unsigned int>(seed, 1 << 5, 400);
+        trie_test::compare_with_map<kora::z_fast_trie<unsigned int, 1, int>, unsigned int>(seed, 2, 50);
+        trie_test::compare_with_map<kora::z_fast_trie<uint64_t, 64, int>, uint64_t>(seed, ~0ull, 4000);
+        trie_test::compare_with_map<kora::z_fast_trie<uint64_t, 64, int, allocator64_t, kora::flat_levels>, uint64_t>(seed, ~0ull, 4000);
+        trie_test::compare_with_map<kora::z_fast_trie<uint64_t, 64, int>, uint64_t>(seed, 1 << 16, 4000);
+    }
+}
+
+TEST_F(z_fast_trie, Basics) {
+    kora::z_fast_trie<unsigned int, 32, std::string> trie;
+    EXPECT_TRUE(trie.empty());
+    EXPECT_EQ(trie.begin(), trie.end());
+    EXPECT_EQ(trie.lower_bound(5), trie.end());
+    EXPECT_EQ(trie.predecessor(5), trie.end());
+    trie.insert({{10, "10"}, {20, "20"}, {0xFFFFFFFF, "max"}, {0, "min"}});
+    EXPECT_EQ(trie.size(), 4u);
+    EXPECT_EQ(trie.at(20), "20");
+    EXPECT_THROW(trie.at(21), std::out_of_range);
+    trie[21] = "21";
+    EXPECT_EQ(trie.at(21), "21");
+    EXPECT_EQ(trie.successor(21)->first, 0xFFFFFFFFu);
+    EXPECT_EQ(trie.successor(0xFFFFFFFF), trie.end());
+    EXPECT_EQ(trie.predecessor(0), trie.end());
+    auto it = trie.erase(trie.find(10));
+    EXPECT_EQ(it->first, 20u);
+    trie.clear();
+    EXPECT_TRUE(trie.empty());
+    EXPECT_EQ(trie.find(20), trie.end());
+    trie.insert({7, "7"});
+    EXPECT_EQ(trie.cbegin()->first, 7u);
+}
+
+TEST_F(z_fast_trie, FewerEntriesThanXFast) {
+    typedef std::allocator<std::pair<const uint64_t, int>> allocator_t;
+    kora::x_fast_trie<uint64_t, 64, int, allocator_t, kora::hashed_levels, kora::counting_stats> x_fast;
+    kora::z_fast_trie<uint64_t, 64, int, allocator_t, kora::hashed_levels, kora::counting_stats> z_fast;
+    std::mt19937_64 random(5);
+    std::vector<uint64_t> keys;
+    for(int i = 0; i < 1000; i++) {
+        keys.push_back(random());
+        x_fast.insert({keys.back(), i});
+        z_fast.insert({keys.back(), i});
+    }
+
+    // One node and one handle for each of the n - 1 branching points.
+    kora::trie_memory memory = z_fast.memory_usage();
+    ASSERT_EQ(memory.levels.size(), 128u);
+    size_t nodes = 0;
+    size_t handles = 0;
+    for(int i = 0; i < 64; i++) {
+        nodes += memory.levels[i].entries;
+        handles += memory.levels[64 + i].entries;
+    }
+    EXPECT_EQ(nodes, 999u);
+    EXPECT_EQ(handles, 999u);
+    EXPECT_LT(memory.total() * 4, x_fast.memory_usage().total());
+
+    // The fat binary search takes at most log2(64) + 1 handle probes.
+    z_fast.reset_stats();
+    for(size_t i = 0; i < keys.size(); i++) {
+        auto it = z_fast.lower_bound(keys[i] + 1);
+        EXPECT_EQ(it == z_fast.end(), x_fast.lower_bound(keys[i] + 1) == x_fast.end());
+    }
+    EXPECT_LE(z_fast.stats().lookup.level_searches, keys.size() * 7);
+}
@@ -0,0 +1,80 @@
+//
+//  sharded_x_fast_trie.h
+//
+//  Thread-safe x-fast-trie split into independently locked shards.
+//  Author: Anil Anar.
+//
+
+#ifndef _sharded_x_fast_trie_h
+#define _sharded_x_fast_trie_h
+
+#include <mutex>
+#include <utility>
+#include <memory>
+
+#include "x_fast_trie.h"
+
+namespace kora {
+    // The top ShardBits bits of a key pick one of 2^ShardBits shards, each an
+    // x_fast_trie over the remaining Width - ShardBits bits guarded by its own
+    // mutex. Threads working on different shards never contend.
+    //
+    // Values are copied out since no reference into a shard stays valid once
+    // its lock is released. Queries spanning shards (predecessor, successor,
+    // for_each) lock one shard at a time, so they see every shard at some
+    // consistent point but not all shards at the same one.
+    template<class KeyT, int Width, class ValueT, int ShardBits = 4, class Allocator = std::allocator<std::pair<const KeyT, ValueT>>, class Levels = hashed_levels>
+    class sharded_x_fast_trie {
+        static_assert(ShardBits > 0 && ShardBits < Width, "ShardBits must leave a key suffix for the shards");
+
+    private:
+        static const int shard_count = 1 << ShardBits;
+        static const int local_width = Width - ShardBits;
+
+        typedef x_fast_trie<KeyT, local_width, ValueT, Allocator, Levels> shard_trie_t;
+
+        // A cache line of its own per shard keeps the locks from false sharing.
+        struct alignas(64) shard {
+            mutable std::mutex lock;
+            shard_trie_t trie;
+        };
+
+        shard _shards[shard_count];
+
+        static int shard_of(KeyT key);
+        static KeyT local_key(KeyT key);
+        static KeyT global_key(int shard_index, KeyT local);
+
+        bool first_of(int shard_index, std::pair<KeyT, ValueT>& out) const;
+        bool last_of(int shard_index, std::pair<KeyT, ValueT>& out) const;
+
+    public:
+        typedef std::pair<KeyT, ValueT> value_type;
+
+        sharded_x_fast_trie();
+
+        bool insert(const KeyT& key, const ValueT& value);
+        void insert_or_assign(const KeyT& key, const ValueT& value);
+        bool erase(const KeyT& key);
+        void clear();
+
+        bool find(const KeyT& key, ValueT& value) const;
+        bool contains(const KeyT& key) const;
+
+        // Largest key below / smallest key above key, false if there is none.
+        bool predecessor(const KeyT& key, value_type& out) const;
+        bool successor(const KeyT& key, value_type& out) const;
+
+        size_t size() const;
+        bool empty() const;
+
+        // Calls f(key, value) in key order. Each shard is locked while it is
+        // visited, f must not call back into the trie.
+        template<class Function>
+        void for_each(Function f) const;
+    };
+}
+
+#include "sharded_x_fast_trie_impl.h"
+
+#endif
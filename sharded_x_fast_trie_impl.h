@@ -0,0 +1,177 @@
+//
+//  sharded_x_fast_trie_impl.h
+//
+//  Thread-safe x-fast-trie split into independently locked shards.
+//  Author: Anil Anar.
+//
+
+#ifndef _sharded_x_fast_trie_impl_h
+#define _sharded_x_fast_trie_impl_h
+
+#define __TMPL      template<class KeyT, int Width, class ValueT, int ShardBits, class Allocator, class Levels>
+#define __CLS       kora::sharded_x_fast_trie<KeyT, Width, ValueT, ShardBits, Allocator, Levels>
+
+#include <cassert>
+
+__TMPL
+__CLS::sharded_x_fast_trie() {
+}
+
+__TMPL
+int __CLS::shard_of(KeyT key) {
+    // Bits above Width would pick a shard past the last one.
+    assert((key >> local_width) < (KeyT)shard_count && "key wider than Width bits");
+    return (int)(key >> local_width);
+}
+
+__TMPL
+KeyT __CLS::local_key(KeyT key) {
+    return key & ((((KeyT)1 << (local_width - 1)) << 1) - 1);
+}
+
+__TMPL
+KeyT __CLS::global_key(int shard_index, KeyT local) {
+    return ((KeyT)shard_index << local_width) | local;
+}
+
+__TMPL
+bool __CLS::first_of(int shard_index, std::pair<KeyT, ValueT>& out) const {
+    const shard& shard_ = _shards[shard_index];
+    std::lock_guard<std::mutex> guard(shard_.lock);
+    typename shard_trie_t::const_iterator it = shard_.trie.cbegin();
+    if(it == shard_.trie.cend())
+        return false;
+    out = std::pair<KeyT, ValueT>(global_key(shard_index, it->first), it->second);
+    return true;
+}
+
+__TMPL
+bool __CLS::last_of(int shard_index, std::pair<KeyT, ValueT>& out) const {
+    const shard& shard_ = _shards[shard_index];
+    std::lock_guard<std::mutex> guard(shard_.lock);
+    typename shard_trie_t::const_iterator it = shard_.trie.rcbegin();
+    if(it == shard_.trie.cend())
+        return false;
+    out = std::pair<KeyT, ValueT>(global_key(shard_index, it->first), it->second);
+    return true;
+}
+
+__TMPL
+bool __CLS::insert(const KeyT& key, const ValueT& value) {
+    shard& shard_ = _shards[shard_of(key)];
+    std::lock_guard<std::mutex> guard(shard_.lock);
+    return shard_.trie.insert({local_key(key), value}).second;
+}
+
+__TMPL
+void __CLS::insert_or_assign(const KeyT& key, const ValueT& value) {
+    shard& shard_ = _shards[shard_of(key)];
+    std::lock_guard<std::mutex> guard(shard_.lock);
+    shard_.trie.insert_or_assign(local_key(key), value);
+}
+
+__TMPL
+bool __CLS::erase(const KeyT& key) {
+    shard& shard_ = _shards[shard_of(key)];
+    std::lock_guard<std::mutex> guard(shard_.lock);
+    typename shard_trie_t::iterator it = shard_.trie.find(local_key(key));
+    if(it == shard_.trie.end())
+        return false;
+    shard_.trie.erase(it);
+    return true;
+}
+
+__TMPL
+void __CLS::clear() {
+    for(int i = 0; i < shard_count; i++) {
+        std::lock_guard<std::mutex> guard(_shards[i].lock);
+        _shards[i].trie.clear();
+    }
+}
+
+__TMPL
+bool __CLS::find(const KeyT& key, ValueT& value) const {
+    const shard& shard_ = _shards[shard_of(key)];
+    std::lock_guard<std::mutex> guard(shard_.lock);
+    typename shard_trie_t::const_iterator it = shard_.trie.find(local_key(key));
+    if(it == shard_.trie.cend())
+        return false;
+    value = it->second;
+    return true;
+}
+
+__TMPL
+bool __CLS::contains(const KeyT& key) const {
+    const shard& shard_ = _shards[shard_of(key)];
+    std::lock_guard<std::mutex> guard(shard_.lock);
+    return shard_.trie.find(local_key(key)) != shard_.trie.cend();
+}
+
+__TMPL
+bool __CLS::predecessor(const KeyT& key, value_type& out) const {
+    int shard_index = shard_of(key);
+    {
+        const shard& shard_ = _shards[shard_index];
+        std::lock_guard<std::mutex> guard(shard_.lock);
+        typename shard_trie_t::const_iterator it = shard_.trie.predecessor(local_key(key));
+        if(it != shard_.trie.cend()) {
+            out = value_type(global_key(shard_index, it->first), it->second);
+            return true;
+        }
+    }
+    for(int i = shard_index - 1; i >= 0; i--) {
+        if(last_of(i, out))
+            return true;
+    }
+    return false;
+}
+
+__TMPL
+bool __CLS::successor(const KeyT& key, value_type& out) const {
+    int shard_index = shard_of(key);
+    {
+        const shard& shard_ = _shards[shard_index];
+        std::lock_guard<std::mutex> guard(shard_.lock);
+        typename shard_trie_t::const_iterator it = shard_.trie.successor(local_key(key));
+        if(it != shard_.trie.cend()) {
+            out = value_type(global_key(shard_index, it->first), it->second);
+            return true;
+        }
+    }
+    for(int i = shard_index + 1; i < shard_count; i++) {
+        if(first_of(i, out))
+            return true;
+    }
+    return false;
+}
+
+__TMPL
+size_t __CLS::size() const {
+    size_t count = 0;
+    for(int i = 0; i < shard_count; i++) {
+        std::lock_guard<std::mutex> guard(_shards[i].lock);
+        count += _shards[i].trie.size();
+    }
+    return count;
+}
+
+__TMPL
+bool __CLS::empty() const {
+    return size() == 0;
+}
+
+__TMPL
+template<class Function>
+void __CLS::for_each(Function f) const {
+    for(int i = 0; i < shard_count; i++) {
+        const shard& shard_ = _shards[i];
+        std::lock_guard<std::mutex> guard(shard_.lock);
+        for(typename shard_trie_t::const_iterator it = shard_.trie.cbegin(); it != shard_.trie.cend(); ++it) {
+            f(global_key(i, it->first), it->second);
+        }
+    }
+}
+
+#undef __CLS
+#undef __TMPL
+#endif
@@ -0,0 +1,110 @@
+//
+//  slab_allocator.h
+//
+//  Chunked allocator for the single-object allocations of kora tries.
+//  Author: Anil Anar.
+//
+
+#ifndef _slab_allocator_h
+#define _slab_allocator_h
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace kora {
+    // Carves equally sized slots out of ChunkSize byte chunks. Freed slots go
+    // to an intrusive free list of their size class, chunks are only returned
+    // by release() or when the arena dies.
+    template<std::size_t ChunkSize>
+    class slab_arena {
+    private:
+        struct chunk {
+            chunk* next;
+        };
+        struct pool {
+            std::size_t slot_size;
+            void* free_list;
+            char* cursor;
+            char* end;
+        };
+
+        chunk* _chunks;
+        std::size_t _reserved;     // bytes of every chunk, oversized ones included
+        std::vector<pool> _pools;
+
+        slab_arena(const slab_arena&);
+        slab_arena& operator=(const slab_arena&);
+
+        pool& pool_for(std::size_t size);
+
+    public:
+        slab_arena();
+        ~slab_arena();
+
+        void* allocate(std::size_t size);
+        void deallocate(void* p, std::size_t size);
+        void release();
+
+        std::size_t reserved_bytes() const;
+    };
+
+    // Standard allocator over a slab_arena. Single objects come from the arena,
+    // arrays go to operator new. Copies and rebinds share the arena, a default
+    // constructed allocator opens a new one.
+    template<class T, std::size_t ChunkSize = 64 * 1024>
+    class slab_allocator {
+    private:
+        template<class, std::size_t>
+        friend class slab_allocator;
+
+        typedef slab_arena<ChunkSize> arena_t;
+        std::shared_ptr<arena_t> _arena;
+
+    public:
+        typedef T                   value_type;
+        typedef T*                  pointer;
+        typedef const T*            const_pointer;
+        typedef T&                  reference;
+        typedef const T&            const_reference;
+        typedef std::size_t         size_type;
+        typedef std::ptrdiff_t      difference_type;
+
+        template<class U>
+        struct rebind { typedef slab_allocator<U, ChunkSize> other; };
+
+        slab_allocator();
+        template<class U>
+        slab_allocator(const slab_allocator<U, ChunkSize>& other);
+
+        T* allocate(std::size_t n);
+        void deallocate(T* p, std::size_t n);
+
+        // Frees every chunk of the arena at once. Objects still living in it
+        // must have been destroyed; their memory must not be deallocated later.
+        void release();
+
+        std::size_t reserved_bytes() const;
+
+        template<class U>
+        bool operator==(const slab_allocator<U, ChunkSize>& other) const { return _arena == other._arena; }
+        template<class U>
+        bool operator!=(const slab_allocator<U, ChunkSize>& other) const { return _arena != other._arena; }
+    };
+
+    // Whether an allocator can drop all of its memory at once through release().
+    template<class Allocator>
+    struct allocator_releases {
+    private:
+        template<class U>
+        static char test(decltype(&U::release));
+        template<class U>
+        static long test(...);
+    public:
+        static const bool value = sizeof(test<Allocator>(0)) == 1;
+    };
+}
+
+#include "slab_allocator_impl.h"
+
+#endif
@@ -0,0 +1,130 @@
+//
+//  slab_allocator_impl.h
+//
+//  Chunked allocator for the single-object allocations of kora tries.
+//  Author: Anil Anar.
+//
+
+#ifndef _slab_allocator_impl_h
+#define _slab_allocator_impl_h
+
+#define __ARENA_TMPL    template<std::size_t ChunkSize>
+#define __ARENA         kora::slab_arena<ChunkSize>
+#define __TMPL          template<class T, std::size_t ChunkSize>
+#define __CLS           kora::slab_allocator<T, ChunkSize>
+
+#include <new>
+
+__ARENA_TMPL
+__ARENA::slab_arena():
+_chunks(NULL),
+_reserved(0) {
+}
+
+__ARENA_TMPL
+__ARENA::~slab_arena() {
+    release();
+}
+
+__ARENA_TMPL
+typename __ARENA::pool& __ARENA::pool_for(std::size_t size) {
+    const std::size_t align = sizeof(void*) > alignof(std::max_align_t) ? sizeof(void*) : alignof(std::max_align_t);
+    std::size_t slot_size = (size + align - 1) / align * align;
+    for(typename std::vector<pool>::iterator it = _pools.begin(); it != _pools.end(); ++it) {
+        if(it->slot_size == slot_size)
+            return *it;
+    }
+    pool new_pool = { slot_size, NULL, NULL, NULL };
+    _pools.push_back(new_pool);
+    return _pools.back();
+}
+
+__ARENA_TMPL
+void* __ARENA::allocate(std::size_t size) {
+    pool& pool_ = pool_for(size);
+    if(pool_.free_list) {
+        void *slot = pool_.free_list;
+        pool_.free_list = *static_cast<void **>(slot);
+        return slot;
+    }
+    if(pool_.cursor + pool_.slot_size > pool_.end || !pool_.cursor) {
+        const std::size_t header = (sizeof(chunk) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+        std::size_t bytes = ChunkSize;
+        if(bytes < header + pool_.slot_size)
+            bytes = header + pool_.slot_size;
+        chunk *new_chunk = static_cast<chunk *>(::operator new(bytes));
+        new_chunk->next = _chunks;
+        _chunks = new_chunk;
+        _reserved += bytes;
+        pool_.cursor = reinterpret_cast<char *>(new_chunk) + header;
+        pool_.end = reinterpret_cast<char *>(new_chunk) + bytes;
+    }
+    void *slot = pool_.cursor;
+    pool_.cursor += pool_.slot_size;
+    return slot;
+}
+
+__ARENA_TMPL
+void __ARENA::deallocate(void* p, std::size_t size) {
+    pool& pool_ = pool_for(size);
+    *static_cast<void **>(p) = pool_.free_list;
+    pool_.free_list = p;
+}
+
+__ARENA_TMPL
+void __ARENA::release() {
+    while(_chunks) {
+        chunk *next = _chunks->next;
+        ::operator delete(_chunks);
+        _chunks = next;
+    }
+    _reserved = 0;
+    _pools.clear();
+}
+
+__ARENA_TMPL
+std::size_t __ARENA::reserved_bytes() const {
+    return _reserved;
+}
+
+__TMPL
+__CLS::slab_allocator():
+_arena(std::make_shared<arena_t>()) {
+}
+
+__TMPL
+template<class U>
+__CLS::slab_allocator(const slab_allocator<U, ChunkSize>& other):
+_arena(other._arena) {
+}
+
+__TMPL
+T* __CLS::allocate(std::size_t n) {
+    if(n == 1)
+        return static_cast<T *>(_arena->allocate(sizeof(T)));
+    return static_cast<T *>(::operator new(n * sizeof(T)));
+}
+
+__TMPL
+void __CLS::deallocate(T* p, std::size_t n) {
+    if(n == 1)
+        _arena->deallocate(p, sizeof(T));
+    else
+        ::operator delete(p);
+}
+
+__TMPL
+void __CLS::release() {
+    _arena->release();
+}
+
+__TMPL
+std::size_t __CLS::reserved_bytes() const {
+    return _arena->reserved_bytes();
+}
+
+#undef __CLS
+#undef __TMPL
+#undef __ARENA
+#undef __ARENA_TMPL
+#endif
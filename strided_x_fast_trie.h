@@ -0,0 +1,127 @@
+//
+//  strided_x_fast_trie.h
+//
+//  X-fast-trie keeping only every Stride-th level of prefixes.
+//  Author: Anil Anar.
+//
+
+#ifndef _strided_x_fast_trie_h
+#define _strided_x_fast_trie_h
+
+#include <cstdint>
+#include <utility>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+#include <iterator>
+
+#include "trie_bits.h"
+#include "trie_leaf.h"
+#include "x_fast_trie_levels.h"
+#include "trie_stats.h"
+#include "trie_memory.h"
+
+namespace kora {
+    // Prefix nodes exist for prefixes of 0, Stride, 2 Stride, ... bits only,
+    // each with a bitmap of which of its 2^Stride children hold keys. A key
+    // takes Width / Stride entries instead of Width, the level search probes
+    // log(Width / Stride) levels and reads the skipped bits off the bitmap
+    // of the deepest node it finds. The price is paid at the bottom: a leaf
+    // is one of up to 2^Stride children of its last node and is reached by
+    // walking at most 2^(Stride - 1) leaves from the nearer end of them.
+    // With Stride 1 this is x_fast_trie with slightly larger nodes.
+    template<class KeyT, int Width, class ValueT, int Stride = 4, class Allocator = std::allocator<std::pair<const KeyT, ValueT>>, class Levels = hashed_levels, class Stats = null_stats>
+    class strided_x_fast_trie {
+        static_assert(Stride >= 1 && Stride <= 8, "Stride must be between 1 and 8 bits.");
+        static_assert(Width >= 1 && Width <= 64, "Width must be between 1 and 64 bits.");
+
+    private:
+        struct strided_node;
+        typedef trie_leaf<KeyT, ValueT> x_leaf_node;
+
+        // Levels kept, the last one's children being the leaves.
+        static const int Depth = (Width + Stride - 1) / Stride;
+
+        typedef typename Levels::template rebind<KeyT, strided_node, Depth, Allocator>::other lookup_t;
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<x_leaf_node> node_allocator_t;
+        node_allocator_t _allocator;
+        typedef std::allocator_traits<node_allocator_t> node_traits_t;
+        typedef typename node_traits_t::pointer x_leaf_node_ptr;
+
+        size_t _count;
+        lookup_t _table;
+        x_leaf_node* _leaf_list;
+        mutable Stats _stats;
+
+        static int chunk(int depth);
+        static KeyT prefix(KeyT key, int depth);
+        static int child(KeyT key, int depth);
+        static int shared_prefix(KeyT key, const x_leaf_node* other);
+
+        const strided_node* bottom(KeyT key, int& depth) const;
+        x_leaf_node* child_leaf(const strided_node* node, int index) const;
+        x_leaf_node* find_node(KeyT key) const;
+        x_leaf_node* ceiling_node(KeyT key) const;
+        x_leaf_node* lower_node(KeyT key) const;
+        x_leaf_node* higher_node(KeyT key) const;
+        x_leaf_node* new_leaf(const std::pair<const KeyT, ValueT>& value);
+        void delete_leaf(x_leaf_node* leaf);
+
+    public:
+        typedef std::pair<const KeyT, ValueT>   value_type;
+        typedef trie_leaf_iterator<strided_x_fast_trie, x_leaf_node, false> iterator;
+        typedef trie_leaf_iterator<strided_x_fast_trie, x_leaf_node, true> const_iterator;
+
+        strided_x_fast_trie();
+        virtual ~strided_x_fast_trie();
+
+        ValueT& at(const KeyT& key);
+        const ValueT& at(const KeyT& key) const;
+
+        ValueT& operator[](const KeyT& key);
+
+        iterator begin();
+        iterator end();
+        const_iterator cbegin() const;
+        const_iterator cend() const;
+
+        bool empty() const;
+        size_t size() const;
+
+        void clear();
+
+        std::pair<iterator, bool> insert(const value_type& value);
+        template<class InputIt>
+        void insert(InputIt first, InputIt last);
+        void insert(std::initializer_list<value_type> ilist);
+
+        iterator    erase(const_iterator pos);
+        size_t      erase(const KeyT& key);
+
+        iterator find(const KeyT& key);
+        const_iterator find(const KeyT& key) const;
+
+        iterator lower_bound(const KeyT& key);
+        const_iterator lower_bound(const KeyT& key) const;
+
+        iterator upper_bound(const KeyT& key);
+        const_iterator upper_bound(const KeyT& key) const;
+
+        // The element with the largest key below key and the one with the
+        // smallest key above it, end() if there is none.
+        iterator predecessor(const KeyT& key);
+        const_iterator predecessor(const KeyT& key) const;
+
+        iterator successor(const KeyT& key);
+        const_iterator successor(const KeyT& key) const;
+
+        // As for x_fast_trie, with one level_memory per level kept.
+        trie_stats stats() const;
+        void reset_stats();
+        trie_memory memory_usage() const;
+    };
+}
+
+#include "strided_x_fast_trie_impl.h"
+
+#endif
@@ -0,0 +1,523 @@
+//
+//  strided_x_fast_trie_impl.h
+//
+//  X-fast-trie keeping only every Stride-th level of prefixes.
+//  Author: Anil Anar.
+//
+
+#ifndef _strided_x_fast_trie_impl_h
+#define _strided_x_fast_trie_impl_h
+
+#define __TMPL      template<class KeyT, int Width, class ValueT, int Stride, class Allocator, class Levels, class Stats>
+#define __CLS       kora::strided_x_fast_trie<KeyT, Width, ValueT, Stride, Allocator, Levels, Stats>
+#define __INNER     typename __CLS
+
+#include <stdexcept>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+// A node of the level keeping prefixes of depth * Stride bits links the
+// smallest (left) and largest (right) leaf below it like an x_fast_trie
+// node, and has bit i of children set if a key continues the prefix with
+// the next chunk bits equal to i.
+__TMPL
+struct __CLS::strided_node {
+    static const int words = ((1 << Stride) + 63) / 64;
+
+    x_leaf_node* left;
+    x_leaf_node* right;
+    uint64_t children[words];
+
+    strided_node(): left(NULL), right(NULL) {
+        for(int w = 0; w < words; w++) {
+            children[w] = 0;
+        }
+    }
+
+    strided_node(x_leaf_node *leaf, int index): left(leaf), right(leaf) {
+        for(int w = 0; w < words; w++) {
+            children[w] = 0;
+        }
+        set(index);
+    }
+
+    bool test(int index) const { return (children[index >> 6] >> (index & 63)) & 1; }
+    void set(int index) { children[index >> 6] |= (uint64_t)1 << (index & 63); }
+    void reset(int index) { children[index >> 6] &= ~((uint64_t)1 << (index & 63)); }
+
+    // Children before index.
+    int rank(int index) const {
+        int count = 0;
+        for(int w = 0; w < index >> 6; w++) {
+            count += __builtin_popcountll(children[w]);
+        }
+        if(index & 63)
+            count += __builtin_popcountll(children[index >> 6] & (((uint64_t)1 << (index & 63)) - 1));
+        return count;
+    }
+
+    int count() const {
+        int count = 0;
+        for(int w = 0; w < words; w++) {
+            count += __builtin_popcountll(children[w]);
+        }
+        return count;
+    }
+
+    // The nearest child below index and above it, -1 if there is none.
+    int below(int index) const {
+        int w = index >> 6;
+        uint64_t bits = children[w] & (((uint64_t)1 << (index & 63)) - 1);
+        for(;;) {
+            if(bits)
+                return w * 64 + 63 - __builtin_clzll(bits);
+            if(--w < 0)
+                return -1;
+            bits = children[w];
+        }
+    }
+
+    int above(int index) const {
+        int w = index >> 6;
+        uint64_t bits = (index & 63) == 63 ? 0 : children[w] & (~(uint64_t)0 << ((index & 63) + 1));
+        for(;;) {
+            if(bits)
+                return w * 64 + __builtin_ctzll(bits);
+            if(++w == words)
+                return -1;
+            bits = children[w];
+        }
+    }
+};
+
+__TMPL
+__CLS::strided_x_fast_trie():
+_count(0),
+_leaf_list(NULL) {
+}
+
+__TMPL
+__CLS::~strided_x_fast_trie() {
+    x_leaf_node *leaf = _leaf_list;
+    for(size_t i = 0; i < _count; i++) {
+        x_leaf_node *next = leaf->right;
+        node_traits_t::destroy(_allocator, leaf);
+        node_traits_t::deallocate(_allocator, leaf, 1);
+        leaf = next;
+    }
+}
+
+__TMPL
+ValueT& __CLS::at(const KeyT& key) {
+    iterator it = find(key);
+    if(it != end())
+        return (*it).second;
+    throw std::out_of_range("Specified key does not exist.");
+}
+
+__TMPL
+const ValueT& __CLS::at(const KeyT& key) const {
+    const_iterator it = find(key);
+    if(it != cend())
+        return (*it).second;
+    throw std::out_of_range("Specified key does not exist.");
+}
+
+__TMPL
+ValueT& __CLS::operator[](const KeyT& key) {
+    return (*insert(value_type(key, ValueT())).first).second;
+}
+
+__TMPL
+__INNER::iterator __CLS::begin() {
+    return iterator(_leaf_list, _leaf_list);
+}
+
+__TMPL
+__INNER::iterator __CLS::end() {
+    return iterator(_leaf_list, NULL);
+}
+
+__TMPL
+__INNER::const_iterator __CLS::cbegin() const {
+    return const_iterator(_leaf_list, _leaf_list);
+}
+
+__TMPL
+__INNER::const_iterator __CLS::cend() const {
+    return const_iterator(_leaf_list, NULL);
+}
+
+__TMPL
+bool __CLS::empty() const {
+    return _count == 0;
+}
+
+__TMPL
+size_t __CLS::size() const {
+    return _count;
+}
+
+__TMPL
+void __CLS::clear() {
+    _stats.begin(trie_erase);
+    x_leaf_node *leaf = _leaf_list;
+    for(size_t i = 0; i < _count; i++) {
+        x_leaf_node *next = leaf->right;
+        delete_leaf(leaf);
+        leaf = next;
+    }
+    _count = 0;
+    _leaf_list = NULL;
+    size_t nodes = 0;
+    for(int i = 0; i < Depth; i++) {
+        nodes += _table.size(i);
+    }
+    _stats.deallocation(nodes);
+    _table.clear();
+}
+
+// Levels holding prefixes the new key shares with neither neighbour get a
+// node each without a lookup. A shared level only changes if the key is
+// its new minimum or maximum or starts a new child, and once a level does
+// not change no shallower one does either.
+__TMPL
+std::pair<__INNER::iterator, bool> __CLS::insert(const value_type& value) {
+    _stats.begin(trie_insert);
+    KeyT key = value.first;
+    x_leaf_node *successor = ceiling_node(key);
+    if(successor && successor->key() == key)
+        return { iterator(_leaf_list, successor), false };
+    x_leaf_node *predecessor = NULL;
+    if(!successor)
+        predecessor = _leaf_list ? _leaf_list->left : NULL;
+    else if(successor != _leaf_list)
+        predecessor = successor->left;
+
+    x_leaf_node *leaf = new_leaf(value);
+    leaves::insert_after(_leaf_list, predecessor, leaf);
+    _count++;
+
+    int before = shared_prefix(key, predecessor);
+    int after = shared_prefix(key, successor);
+    int shared = before > after ? before : after;
+    for(int depth = Depth - 1; depth >= 0; depth--) {
+        int length = depth * Stride;
+        if(length > shared) {
+            _table.insert(depth, prefix(key, depth), strided_node(leaf, child(key, depth)));
+            _stats.hash_probe();
+            _stats.allocation();
+            continue;
+        }
+        bool new_child = length + chunk(depth) > shared;
+        bool new_min = before < length;
+        bool new_max = after < length;
+        if(!new_child && !new_min && !new_max)
+            break;
+        strided_node *node = _table.find(depth, prefix(key, depth));
+        _stats.hash_probe();
+        if(new_child)
+            node->set(child(key, depth));
+        if(new_min)
+            node->left = leaf;
+        if(new_max)
+            node->right = leaf;
+    }
+    return { iterator(_leaf_list, leaf), true };
+}
+
+__TMPL
+template<class InputIt>
+void __CLS::insert(InputIt first, InputIt last) {
+    for(; first != last; ++first) {
+        insert(*first);
+    }
+}
+
+__TMPL
+void __CLS::insert(std::initializer_list<value_type> ilist) {
+    insert(ilist.begin(), ilist.end());
+}
+
+// The mirror image of insert: levels the key shares with neither neighbour
+// lose their node, shared ones may lose their minimum, maximum or a child.
+__TMPL
+__INNER::iterator __CLS::erase(const_iterator pos) {
+    _stats.begin(trie_erase);
+    x_leaf_node *leaf = pos._node;
+    KeyT key = leaf->key();
+    x_leaf_node *predecessor = leaf == _leaf_list ? NULL : leaf->left;
+    x_leaf_node *successor = leaf->right == _leaf_list ? NULL : leaf->right;
+    int before = shared_prefix(key, predecessor);
+    int after = shared_prefix(key, successor);
+    int shared = before > after ? before : after;
+    leaves::unlink(_leaf_list, leaf);
+
+    for(int depth = Depth - 1; depth >= 0; depth--) {
+        int length = depth * Stride;
+        if(length > shared) {
+            _table.erase(depth, prefix(key, depth));
+            _stats.hash_probe();
+            _stats.deallocation();
+            continue;
+        }
+        bool lost_child = length + chunk(depth) > shared;
+        bool lost_min = before < length;
+        bool lost_max = after < length;
+        if(!lost_child && !lost_min && !lost_max)
+            break;
+        strided_node *node = _table.find(depth, prefix(key, depth));
+        _stats.hash_probe();
+        if(lost_child)
+            node->reset(child(key, depth));
+        if(lost_min)
+            node->left = successor;
+        if(lost_max)
+            node->right = predecessor;
+    }
+    _count--;
+    delete_leaf(leaf);
+    return iterator(_leaf_list, successor);
+}
+
+__TMPL
+size_t __CLS::erase(const KeyT& key) {
+    const_iterator it = find(key);
+    if(it == cend())
+        return 0;
+    erase(it);
+    return 1;
+}
+
+__TMPL
+__INNER::iterator __CLS::find(const KeyT& key) {
+    _stats.begin(trie_lookup);
+    return iterator(_leaf_list, find_node(key));
+}
+
+__TMPL
+__INNER::const_iterator __CLS::find(const KeyT& key) const {
+    _stats.begin(trie_lookup);
+    return const_iterator(_leaf_list, find_node(key));
+}
+
+__TMPL
+__INNER::iterator __CLS::lower_bound(const KeyT& key) {
+    _stats.begin(trie_lookup);
+    return iterator(_leaf_list, ceiling_node(key));
+}
+
+__TMPL
+__INNER::const_iterator __CLS::lower_bound(const KeyT& key) const {
+    _stats.begin(trie_lookup);
+    return const_iterator(_leaf_list, ceiling_node(key));
+}
+
+__TMPL
+__INNER::iterator __CLS::upper_bound(const KeyT& key) {
+    _stats.begin(trie_lookup);
+    return iterator(_leaf_list, higher_node(key));
+}
+
+__TMPL
+__INNER::const_iterator __CLS::upper_bound(const KeyT& key) const {
+    _stats.begin(trie_lookup);
+    return const_iterator(_leaf_list, higher_node(key));
+}
+
+__TMPL
+__INNER::iterator __CLS::predecessor(const KeyT& key) {
+    _stats.begin(trie_lookup);
+    return iterator(_leaf_list, lower_node(key));
+}
+
+__TMPL
+__INNER::const_iterator __CLS::predecessor(const KeyT& key) const {
+    _stats.begin(trie_lookup);
+    return const_iterator(_leaf_list, lower_node(key));
+}
+
+__TMPL
+__INNER::iterator __CLS::successor(const KeyT& key) {
+    _stats.begin(trie_lookup);
+    return iterator(_leaf_list, higher_node(key));
+}
+
+__TMPL
+__INNER::const_iterator __CLS::successor(const KeyT& key) const {
+    _stats.begin(trie_lookup);
+    return const_iterator(_leaf_list, higher_node(key));
+}
+
+__TMPL
+kora::trie_stats __CLS::stats() const {
+    return _stats.snapshot();
+}
+
+__TMPL
+void __CLS::reset_stats() {
+    _stats.reset();
+}
+
+__TMPL
+kora::trie_memory __CLS::memory_usage() const {
+    trie_memory memory;
+    memory.levels.resize(Depth);
+    memory.shared_table_bytes = _table.memory_usage(&memory.levels[0]);
+    memory.leaf_count = _count;
+    memory.leaf_bytes = _count * sizeof(x_leaf_node);
+    memory.allocator_overhead = 0;
+    if(!allocator_releases<node_allocator_t>::value)
+        memory.allocator_overhead = _count * (bits::heap_block_bytes(sizeof(x_leaf_node)) - sizeof(x_leaf_node));
+    memory.object_bytes = sizeof(*this);
+    return memory;
+}
+
+// Bits a node at depth tells apart, fewer than Stride at the last level
+// when Stride does not divide Width.
+__TMPL
+int __CLS::chunk(int depth) {
+    int rest = Width - depth * Stride;
+    return rest < Stride ? rest : Stride;
+}
+
+__TMPL
+KeyT __CLS::prefix(KeyT key, int depth) {
+    return bits::prefix<KeyT, Width>(key, depth * Stride);
+}
+
+__TMPL
+int __CLS::child(KeyT key, int depth) {
+    int bits = chunk(depth);
+    return (int)(((uint64_t)key >> (Width - depth * Stride - bits)) & (((uint64_t)1 << bits) - 1));
+}
+
+// Length of the prefix key shares with other, -1 without other.
+__TMPL
+int __CLS::shared_prefix(KeyT key, const x_leaf_node* other) {
+    if(!other)
+        return -1;
+    return bits::common_prefix<KeyT, Width>(key, other->key());
+}
+
+__TMPL
+const __INNER::strided_node* __CLS::bottom(KeyT key, int& depth) const {
+    const strided_node *deepest = NULL;
+    int low = 0;
+    int high = _leaf_list ? Depth : 0;
+    while(low < high) {
+        int j = (low + high) / 2;
+        const strided_node *node = _table.find(j, prefix(key, j));
+        _stats.level_search();
+        _stats.hash_probe();
+        if(node) {
+            low = j + 1;
+            deepest = node;
+            depth = j;
+        } else {
+            high = j;
+        }
+    }
+    return deepest;
+}
+
+// The leaves below a node of the last level are its children in order, so
+// the one at index is rank steps from the smallest or fewer from the
+// largest.
+__TMPL
+__INNER::x_leaf_node* __CLS::child_leaf(const strided_node* node, int index) const {
+    int rank = node->rank(index);
+    int rest = node->count() - 1 - rank;
+    x_leaf_node *leaf;
+    if(rank <= rest) {
+        leaf = node->left;
+        for(int i = 0; i < rank; i++) {
+            leaf = leaf->right;
+            _stats.leaf_hop();
+        }
+    } else {
+        leaf = node->right;
+        for(int i = 0; i < rest; i++) {
+            leaf = leaf->left;
+            _stats.leaf_hop();
+        }
+    }
+    return leaf;
+}
+
+__TMPL
+__INNER::x_leaf_node* __CLS::find_node(KeyT key) const {
+    if(!_leaf_list)
+        return NULL;
+    const strided_node *node = _table.find(Depth - 1, prefix(key, Depth - 1));
+    _stats.hash_probe();
+    int index = child(key, Depth - 1);
+    if(!node || !node->test(index))
+        return NULL;
+    return child_leaf(node, index);
+}
+
+// Below the deepest node holding a prefix of key, key's own child is empty
+// unless it is a leaf. The smallest key above key is then the minimum of
+// the nearest child above it, found without a lookup when no child lies
+// below key as the node's minimum, and the maximum's right neighbour when
+// none lies above.
+__TMPL
+__INNER::x_leaf_node* __CLS::ceiling_node(KeyT key) const {
+    int depth = 0;
+    const strided_node *node = bottom(key, depth);
+    if(!node)
+        return NULL;
+    int index = child(key, depth);
+    bool last = depth == Depth - 1;
+    if(last && node->test(index))
+        return child_leaf(node, index);
+    int higher = node->above(index);
+    if(higher < 0) {
+        _stats.leaf_hop();
+        return node->right->right == _leaf_list ? NULL : node->right->right;
+    }
+    if(node->below(index) < 0)
+        return node->left;
+    if(last)
+        return child_leaf(node, higher);
+    KeyT next = (prefix(key, depth) << Stride) | (KeyT)higher;
+    _stats.hash_probe();
+    return _table.find(depth + 1, next)->left;
+}
+
+__TMPL
+__INNER::x_leaf_node* __CLS::lower_node(KeyT key) const {
+    x_leaf_node *ceiling = ceiling_node(key);
+    if(!ceiling)
+        return _leaf_list ? _leaf_list->left : NULL;
+    _stats.leaf_hop();
+    return ceiling == _leaf_list ? NULL : ceiling->left;
+}
+
+__TMPL
+__INNER::x_leaf_node* __CLS::higher_node(KeyT key) const {
+    x_leaf_node *ceiling = ceiling_node(key);
+    if(!ceiling || ceiling->key() != key)
+        return ceiling;
+    _stats.leaf_hop();
+    if(ceiling->right == _leaf_list)
+        return NULL;
+    return ceiling->right;
+}
+
+__TMPL
+__INNER::x_leaf_node* __CLS::new_leaf(const std::pair<const KeyT, ValueT>& value) {
+    return leaves::create(_allocator, _stats, value);
+}
+
+__TMPL
+void __CLS::delete_leaf(x_leaf_node* leaf) {
+    leaves::destroy(_allocator, _stats, leaf);
+}
+
+#undef __INNER
+#undef __CLS
+#undef __TMPL
+#endif
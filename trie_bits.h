@@ -0,0 +1,156 @@
+//
+//  trie_bits.h
+//
+//  Bit helpers shared by the kora tries.
+//  Author: Anil Anar.
+//
+
+#ifndef _trie_bits_h
+#define _trie_bits_h
+
+#include <cstdint>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace kora {
+    namespace bits {
+        // Number of leading bits two distinct Width-bit keys have in common,
+        // i.e. the deepest level whose prefix node holds both of them.
+        template<class KeyT, int Width>
+        inline int common_prefix(KeyT a, KeyT b) {
+            uint64_t diff = (uint64_t)(a ^ b) << (64 - Width);
+            return __builtin_clzll(diff);
+        }
+
+        // The top length bits of a Width-bit key, also defined for length 0.
+        template<class KeyT, int Width>
+        inline KeyT prefix(KeyT key, int length) {
+            return key >> (Width - 1 - length) >> 1;
+        }
+
+        // The top Length bits of a Width-bit key, with the shift a constant.
+        template<class KeyT, int Width, int Length>
+        inline KeyT prefix(KeyT key) {
+            return key >> (Width - 1 - Length) >> 1;
+        }
+
+        // Binary search for the deepest level in [Low, High) holding a prefix
+        // of key, unrolled at compile time. Levels are probed through
+        // table.find(level, prefix); found is the deepest node seen so far.
+        template<class KeyT, int Width, int Low, int High>
+        struct level_search {
+            template<class Table, class NodeT>
+            static NodeT* deepest(Table& table, KeyT key, NodeT* found) {
+                const int level = (Low + High) / 2;
+                NodeT *node = table.find(level, prefix<KeyT, Width, level>(key));
+                if(node)
+                    return level_search<KeyT, Width, level + 1, High>::deepest(table, key, node);
+                return level_search<KeyT, Width, Low, level>::deepest(table, key, found);
+            }
+        };
+
+        template<class KeyT, int Width, int Level>
+        struct level_search<KeyT, Width, Level, Level> {
+            template<class Table, class NodeT>
+            static NodeT* deepest(Table&, KeyT, NodeT* found) {
+                return found;
+            }
+        };
+
+        // Mixes a (level, prefix) pair into 64 bits whose top bits are well
+        // spread, for tables indexing with hash >> (64 - log2(capacity)).
+        inline uint64_t level_hash(int level, uint64_t prefix) {
+            uint64_t h = (prefix ^ ((uint64_t)level * 0x9E3779B97F4A7C15ull)) * 0xBF58476D1CE4E5B9ull;
+            h ^= h >> 31;
+            return h * 0x94D049BB133111EBull;
+        }
+
+        // level_hash of the prefixes of a width-bit key at levels [from, to),
+        // written to out[0] onwards. The kernels compute a lane per level:
+        // the prefix is key shifted right by width - level, which variable
+        // vector shifts take to 0 at level 0, then the hash. level_hashes
+        // runs the widest kernel the CPU supports, picked on first use.
+        typedef void (*level_hash_kernel)(uint64_t key, int width, int from, int to, uint64_t* out);
+
+        inline void level_hashes_scalar(uint64_t key, int width, int from, int to, uint64_t* out) {
+            for(int level = from; level < to; level++) {
+                *out++ = level_hash(level, width - level < 64 ? key >> (width - level) : 0);
+            }
+        }
+
+#if defined(__x86_64__)
+        // AVX2 has no 64-bit multiply, it is put together from 32-bit ones.
+        __attribute__((target("avx2")))
+        inline __m256i multiply_avx2(__m256i a, __m256i b) {
+            __m256i low = _mm256_mul_epu32(a, b);
+            __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b), _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+            return _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32));
+        }
+
+        __attribute__((target("avx2")))
+        inline void level_hashes_avx2(uint64_t key, int width, int from, int to, uint64_t* out) {
+            const __m256i keys = _mm256_set1_epi64x((long long)key);
+            const __m256i widths = _mm256_set1_epi64x(width);
+            const __m256i golden = _mm256_set1_epi64x((long long)0x9E3779B97F4A7C15ull);
+            const __m256i mix1 = _mm256_set1_epi64x((long long)0xBF58476D1CE4E5B9ull);
+            const __m256i mix2 = _mm256_set1_epi64x((long long)0x94D049BB133111EBull);
+            __m256i levels = _mm256_add_epi64(_mm256_set1_epi64x(from), _mm256_setr_epi64x(0, 1, 2, 3));
+            int level = from;
+            for(; level + 4 <= to; level += 4, out += 4) {
+                __m256i prefixes = _mm256_srlv_epi64(keys, _mm256_sub_epi64(widths, levels));
+                __m256i h = multiply_avx2(_mm256_xor_si256(prefixes, multiply_avx2(levels, golden)), mix1);
+                h = _mm256_xor_si256(h, _mm256_srli_epi64(h, 31));
+                _mm256_storeu_si256((__m256i *)out, multiply_avx2(h, mix2));
+                levels = _mm256_add_epi64(levels, _mm256_set1_epi64x(4));
+            }
+            level_hashes_scalar(key, width, level, to, out);
+        }
+
+        __attribute__((target("avx512f,avx512dq")))
+        inline void level_hashes_avx512(uint64_t key, int width, int from, int to, uint64_t* out) {
+            const __m512i keys = _mm512_set1_epi64((long long)key);
+            const __m512i widths = _mm512_set1_epi64(width);
+            const __m512i golden = _mm512_set1_epi64((long long)0x9E3779B97F4A7C15ull);
+            const __m512i mix1 = _mm512_set1_epi64((long long)0xBF58476D1CE4E5B9ull);
+            const __m512i mix2 = _mm512_set1_epi64((long long)0x94D049BB133111EBull);
+            __m512i levels = _mm512_add_epi64(_mm512_set1_epi64(from), _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7));
+            // The zero-masking shifts with every lane set stand in for the plain
+            // ones, whose undefined pass-through vector GCC warns about.
+            const __mmask8 all = 0xFF;
+            for(int level = from; level < to; level += 8, out += 8) {
+                __m512i prefixes = _mm512_maskz_srlv_epi64(all, keys, _mm512_sub_epi64(widths, levels));
+                __m512i h = _mm512_mullo_epi64(_mm512_xor_si512(prefixes, _mm512_mullo_epi64(levels, golden)), mix1);
+                h = _mm512_xor_si512(h, _mm512_maskz_srli_epi64(all, h, 31));
+                h = _mm512_mullo_epi64(h, mix2);
+                int lanes = to - level < 8 ? to - level : 8;
+                _mm512_mask_storeu_epi64(out, (__mmask8)((1u << lanes) - 1), h);
+                levels = _mm512_add_epi64(levels, _mm512_set1_epi64(8));
+            }
+        }
+#endif
+
+        inline level_hash_kernel best_level_hash_kernel() {
+#if defined(__x86_64__)
+            __builtin_cpu_init();
+            if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq"))
+                return level_hashes_avx512;
+            if(__builtin_cpu_supports("avx2"))
+                return level_hashes_avx2;
+#endif
+            return level_hashes_scalar;
+        }
+
+        inline void level_hashes(uint64_t key, int width, int from, int to, uint64_t* out) {
+            static const level_hash_kernel kernel = best_level_hash_kernel();
+            kernel(key, width, from, to, out);
+        }
+
+        // Hint that address is about to be read.
+        inline void prefetch(const void* address) {
+            __builtin_prefetch(address, 0, 3);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,147 @@
+//
+//  trie_leaf.h
+//
+//  Leaf list and iterator shared by the kora tries.
+//  Author: Anil Anar.
+//
+
+#ifndef _trie_leaf_h
+#define _trie_leaf_h
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace kora {
+    // Leaves form a circular doubly linked list in key order, the trie
+    // holding a pointer to the smallest one.
+    template<class KeyT, class ValueT>
+    struct trie_leaf {
+        typedef std::pair<const KeyT, ValueT> value_type;
+
+        trie_leaf* left;
+        trie_leaf* right;
+        value_type key_value;
+
+        template<class... Args>
+        trie_leaf(Args&&... args): left(NULL), right(NULL), key_value(std::forward<Args>(args)...)
+        {}
+
+        const KeyT& key() const { return key_value.first; }
+        ValueT& value() { return key_value.second; }
+        const ValueT& value() const { return key_value.second; }
+    };
+
+    // Walks a leaf list, end being a NULL node. Only Owner, the trie, hands
+    // out iterators to a leaf; a const iterator converts from a mutable one.
+    template<class Owner, class Leaf, bool IsConst>
+    class trie_leaf_iterator : public std::iterator<std::bidirectional_iterator_tag, typename Leaf::value_type, size_t> {
+    private:
+        typedef typename std::conditional<IsConst, const typename Leaf::value_type, typename Leaf::value_type>::type ValueTypeT;
+
+        friend Owner;
+        template<class, class, bool>
+        friend class trie_leaf_iterator;
+        Leaf *_node;
+        Leaf *_leaf_list;
+        trie_leaf_iterator(Leaf* leaf_list, Leaf* node): _node(node), _leaf_list(leaf_list) {}
+    public:
+        template<bool OtherConst, class = typename std::enable_if<IsConst && !OtherConst>::type>
+        trie_leaf_iterator(const trie_leaf_iterator<Owner, Leaf, OtherConst>& other): _node(other._node), _leaf_list(other._leaf_list) {}
+
+        ValueTypeT& operator*() const { return _node->key_value; }
+        ValueTypeT* operator->() const { return &(_node->key_value); }
+        const trie_leaf_iterator& operator++() {
+            _node = _node->right;
+            if(_node == _leaf_list) _node = NULL;
+            return *this;
+        }
+        trie_leaf_iterator operator++(int) {
+            trie_leaf_iterator previous = *this;
+            ++(*this);
+            return previous;
+        }
+        const trie_leaf_iterator& operator--() {
+            _node = _node->left;
+            if(_node == _leaf_list->left) _node = NULL;
+            return *this;
+        }
+        trie_leaf_iterator operator--(int) {
+            trie_leaf_iterator previous = *this;
+            --(*this);
+            return previous;
+        }
+        template<bool OtherConst>
+        bool operator==(const trie_leaf_iterator<Owner, Leaf, OtherConst>& other) const {
+            return _node == other._node;
+        }
+        template<bool OtherConst>
+        bool operator!=(const trie_leaf_iterator<Owner, Leaf, OtherConst>& other) const {
+            return _node != other._node;
+        }
+    };
+
+    namespace leaves {
+        // Links leaf right after marker, at the front if marker is NULL.
+        template<class Leaf>
+        inline void insert_after(Leaf*& leaf_list, Leaf* marker, Leaf* leaf) {
+            if(marker == NULL) {
+                if(leaf_list == NULL) {
+                    leaf->left = leaf;
+                    leaf->right = leaf;
+                } else {
+                    leaf_list->left->right = leaf;
+                    leaf->left = leaf_list->left;
+                    leaf->right = leaf_list;
+                    leaf_list->left = leaf;
+                }
+                leaf_list = leaf;
+            } else {
+                Leaf *right_node = marker->right;
+                marker->right = leaf;
+                leaf->left = marker;
+                leaf->right = right_node;
+                right_node->left = leaf;
+            }
+        }
+
+        // Takes leaf out of the list, leaving its own links as they were.
+        template<class Leaf>
+        inline void unlink(Leaf*& leaf_list, Leaf* leaf) {
+            if(leaf->right == leaf) {
+                leaf_list = NULL;
+                return;
+            }
+            leaf->left->right = leaf->right;
+            leaf->right->left = leaf->left;
+            if(leaf == leaf_list)
+                leaf_list = leaf->right;
+        }
+
+        // Allocates and constructs a leaf, counted as an allocation in stats.
+        template<class Allocator, class Stats, class... Args>
+        inline typename std::allocator_traits<Allocator>::pointer create(Allocator& allocator, Stats& stats, Args&&... args) {
+            typedef std::allocator_traits<Allocator> traits_t;
+            typename traits_t::pointer leaf = traits_t::allocate(allocator, 1);
+            try {
+                traits_t::construct(allocator, leaf, std::forward<Args>(args)...);
+            } catch(...) {
+                traits_t::deallocate(allocator, leaf, 1);
+                throw;
+            }
+            stats.allocation();
+            return leaf;
+        }
+
+        template<class Allocator, class Stats>
+        inline void destroy(Allocator& allocator, Stats& stats, typename std::allocator_traits<Allocator>::pointer leaf) {
+            std::allocator_traits<Allocator>::destroy(allocator, leaf);
+            std::allocator_traits<Allocator>::deallocate(allocator, leaf, 1);
+            stats.deallocation();
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,55 @@
+//
+//  trie_memory.h
+//
+//  Memory footprint reports of kora tries.
+//  Author: Anil Anar.
+//
+
+#ifndef _trie_memory_h
+#define _trie_memory_h
+
+#include <cstddef>
+#include <vector>
+
+namespace kora {
+    // Footprint of one level of prefix nodes.
+    struct level_memory {
+        size_t entries;
+        size_t buckets;         // buckets of the level's hash table, 0 if it has none of its own
+        size_t node_bytes;      // bytes of the entries themselves
+        size_t bucket_bytes;    // bytes of the bucket array
+        size_t overhead;        // estimated heap bookkeeping around separately allocated entries
+    };
+
+    struct trie_memory {
+        std::vector<level_memory> levels;
+        size_t shared_table_bytes;  // level storage belonging to no single level, e.g. empty shared slots
+        size_t leaf_count;
+        size_t leaf_bytes;
+        size_t allocator_overhead;  // heap bookkeeping or unused arena space around the leaves
+        size_t object_bytes;        // the trie object itself
+
+        size_t total() const {
+            size_t bytes = shared_table_bytes + leaf_bytes + allocator_overhead + object_bytes;
+            for(size_t i = 0; i < levels.size(); i++) {
+                bytes += levels[i].node_bytes + levels[i].bucket_bytes + levels[i].overhead;
+            }
+            return bytes;
+        }
+
+        double bytes_per_key() const {
+            return leaf_count ? (double)total() / leaf_count : 0;
+        }
+    };
+
+    namespace bits {
+        // Bytes glibc malloc takes for a block of size bytes: an 8 byte
+        // header, 16 byte granularity and 32 bytes at least.
+        inline size_t heap_block_bytes(size_t size) {
+            size_t block = (size + 8 + 15) & ~(size_t)15;
+            return block < 32 ? 32 : block;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,85 @@
+//
+//  trie_probing.h
+//
+//  Robin Hood probing shared by the open-addressing level tables.
+//  Author: Anil Anar.
+//
+
+#ifndef _trie_probing_h
+#define _trie_probing_h
+
+#include <cstddef>
+
+namespace kora {
+    namespace probing {
+        // Every slot records its probe distance + 1, 0 marking an empty slot.
+        // Runs are kept under max_distance so the distance fits a byte.
+        static const unsigned char max_distance = 255;
+
+        // The loops below reach the slots through a Slots adapter, which lets
+        // flat_level_table use plain slots and concurrent_x_fast_trie atomic
+        // ones. It provides
+        //
+        //     typedef ... entry;                  a slot's contents, with a distance field
+        //     size_t mask() const;                capacity - 1
+        //     unsigned char distance(size_t i) const;
+        //     bool holds(size_t i, int level, KeyT prefix) const;
+        //     entry load(size_t i) const;
+        //     void store(size_t i, const entry& entry_);
+        //     void vacate(size_t i);              marks slot i empty
+
+        // Probes from slot i, the home of (level, prefix). Returns the slot
+        // holding it or mask() + 1.
+        template<class Slots, class KeyT>
+        inline size_t locate(const Slots& slots, size_t i, int level, KeyT prefix) {
+            for(unsigned int distance = 1; distance <= max_distance; distance++, i = (i + 1) & slots.mask()) {
+                if(slots.distance(i) < distance)
+                    break;
+                if(slots.holds(i, level, prefix))
+                    return i;
+            }
+            return slots.mask() + 1;
+        }
+
+        // Places entry_ from slot i, its home, swapping it with every richer
+        // resident it passes. Returns false if a run reaches max_distance,
+        // the entry left without a slot is then in entry_.
+        template<class Slots>
+        inline bool place(Slots& slots, typename Slots::entry& entry_, size_t i) {
+            entry_.distance = 1;
+            for(;; i = (i + 1) & slots.mask()) {
+                unsigned char distance = slots.distance(i);
+                if(distance == 0) {
+                    slots.store(i, entry_);
+                    return true;
+                }
+                if(distance < entry_.distance) {
+                    typename Slots::entry resident = slots.load(i);
+                    slots.store(i, entry_);
+                    entry_ = resident;
+                }
+                if(entry_.distance == max_distance)
+                    return false;
+                entry_.distance++;
+            }
+        }
+
+        // Backward-shift deletion of slot i: the run after it moves up a slot
+        // until an empty slot or an entry already at its home.
+        template<class Slots>
+        inline void remove(Slots& slots, size_t i) {
+            for(;;) {
+                size_t next = (i + 1) & slots.mask();
+                if(slots.distance(next) <= 1)
+                    break;
+                typename Slots::entry entry_ = slots.load(next);
+                entry_.distance--;
+                slots.store(i, entry_);
+                i = next;
+            }
+            slots.vacate(i);
+        }
+    }
+}
+
+#endif
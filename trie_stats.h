@@ -0,0 +1,86 @@
+//
+//  trie_stats.h
+//
+//  Stats policies counting the work done by x_fast_trie operations.
+//  Author: Anil Anar.
+//
+
+#ifndef _trie_stats_h
+#define _trie_stats_h
+
+#include <cstdint>
+#include <cstddef>
+
+namespace kora {
+    // Work done by one kind of operation.
+    struct operation_counters {
+        uint64_t calls;
+        uint64_t hash_probes;       // level table finds, inserts and erases
+        uint64_t level_searches;    // levels probed looking for the deepest prefix
+        uint64_t allocations;       // leaves and prefix nodes allocated
+        uint64_t frees;             // leaves and prefix nodes freed
+        uint64_t leaf_hops;         // leaf list links followed while searching
+    };
+
+    // Lookups are find, at and the ordered queries; inserts are insert,
+    // operator[] and build_sorted; erases are erase and clear. Composite
+    // operations count as the ones they are made of; operator[] counts as
+    // one insert.
+    struct trie_stats {
+        operation_counters lookup;
+        operation_counters insert;
+        operation_counters erase;
+    };
+
+    enum trie_operation {
+        trie_lookup,
+        trie_insert,
+        trie_erase
+    };
+
+    // The default policy: counts nothing and compiles down to nothing.
+    struct null_stats {
+        void begin(trie_operation, size_t = 1) {}
+        void hash_probe(size_t = 1) {}
+        void level_search() {}
+        void allocation(size_t = 1) {}
+        void deallocation(size_t = 1) {}
+        void leaf_hop() {}
+
+        trie_stats snapshot() const { return trie_stats(); }
+        void reset() {}
+    };
+
+    // Counts everything, attributing work to the operation begun last.
+    class counting_stats {
+    private:
+        operation_counters _counters[3];
+        int _current;
+
+    public:
+        counting_stats(): _current(trie_lookup) { reset(); }
+
+        void begin(trie_operation operation, size_t calls = 1) {
+            _current = operation;
+            _counters[_current].calls += calls;
+        }
+        void hash_probe(size_t count = 1) { _counters[_current].hash_probes += count; }
+        void level_search() { _counters[_current].level_searches++; }
+        void allocation(size_t count = 1) { _counters[_current].allocations += count; }
+        void deallocation(size_t count = 1) { _counters[_current].frees += count; }
+        void leaf_hop() { _counters[_current].leaf_hops++; }
+
+        trie_stats snapshot() const {
+            trie_stats stats = { _counters[trie_lookup], _counters[trie_insert], _counters[trie_erase] };
+            return stats;
+        }
+        void reset() {
+            for(int i = 0; i < 3; i++) {
+                operation_counters zero = {};
+                _counters[i] = zero;
+            }
+        }
+    };
+}
+
+#endif
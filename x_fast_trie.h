@@ -12,42 +12,96 @@
 #include <utility>
 #include <initializer_list>
 #include <memory>
+#include <type_traits>
+#include <iterator>
+#include <vector>
+
+#include "trie_bits.h"
+#include "trie_leaf.h"
+#include "x_fast_trie_levels.h"
+#include "slab_allocator.h"
+#include "trie_stats.h"
+#include "trie_memory.h"
 
 namespace kora {
-    template<class KeyT, int Width, class ValueT, class Allocator = std::allocator<std::pair<const KeyT, ValueT>>>
+    // Marks a range as sorted by key without duplicates.
+    struct sorted_unique_t {};
+    const sorted_unique_t sorted_unique = sorted_unique_t();
+    
+    // Stats is null_stats or counting_stats, see trie_stats.h. Levels
+    // defaults to dense_levels for widths up to 16, hashed_levels above. A
+    // dense table reserves 2^Width - 1 prefix nodes and their bitmap on the
+    // first insert, whatever the size: about 1 MB at width 16, 16 MB at 20,
+    // all of it counted by memory_usage().
+    template<class KeyT, int Width, class ValueT, class Allocator = std::allocator<std::pair<const KeyT, ValueT>>, class Levels = typename default_levels<Width>::type, class Stats = null_stats>
     class x_fast_trie {
     private:
         struct x_fast_node;
-        struct x_leaf_node;
-        template<bool IsConst>
-        class x_fast_trie_iterator;
-        class x_fast_trie_const_iterator;
+        typedef trie_leaf<KeyT, ValueT> x_leaf_node;
+        typedef trie_leaf_iterator<x_fast_trie, x_leaf_node, false> x_fast_trie_iterator;
+        typedef trie_leaf_iterator<x_fast_trie, x_leaf_node, true> x_fast_trie_const_iterator;
         
-        typedef std::unordered_map<KeyT, x_fast_node> lookup_t;
+        typedef typename Levels::template rebind<KeyT, x_fast_node, Width, Allocator>::other lookup_t;
         typedef typename std::allocator_traits<Allocator>::template rebind_alloc<x_leaf_node> node_allocator_t;
         node_allocator_t _allocator;
-        typedef typename std::allocator_traits<node_allocator_t>::pointer x_leaf_node_ptr;
+        typedef std::allocator_traits<node_allocator_t> node_traits_t;
+        typedef typename node_traits_t::pointer x_leaf_node_ptr;
         
         size_t _count;
-        int _width;
         int _version;
         
-        lookup_t _table[Width];
+        lookup_t _table;
         x_leaf_node* _leaf_list;
-        
-        x_fast_node* bottom(KeyT key);
-        void insert_leaf_after(x_fast_node* marker, x_leaf_node* new_leaf);
-        x_leaf_node* lower_node_from_bottom(x_fast_node *bottom, KeyT key);
-        x_leaf_node* lower_node(KeyT key);
-        x_leaf_node* higher_node(KeyT key);
+        mutable Stats _stats;
+        
+        // The level table as bits::level_search sees it, counting probes.
+        struct counted_levels {
+            const lookup_t& table;
+            Stats& stats;
+            const x_fast_node* find(int level, KeyT prefix) const;
+        };
+        
+        void reset();
+        void destroy_leaves(std::false_type);
+        void destroy_leaves(std::true_type);
+        size_t allocator_overhead(std::false_type) const;
+        size_t allocator_overhead(std::true_type) const;
+        static const size_t batch_size = 16;
+        
+        const x_fast_node* bottom(KeyT key) const;
+        const x_fast_node* locate(KeyT key, x_leaf_node*& found) const;
+        template<class... Args>
+        x_leaf_node* new_leaf(Args&&... args);
+        void delete_leaf(x_leaf_node* leaf);
+        template<class K, class... Args>
+        std::pair<x_fast_trie_iterator, bool> emplace_key(K&& key, Args&&... args);
+        template<class K, class... Args>
+        x_fast_trie_iterator emplace_key(x_fast_trie_const_iterator hint, K&& key, Args&&... args);
+        void link_leaf(x_leaf_node* predecessor, x_leaf_node* leaf);
+        void publish_prefix(int level, x_leaf_node* low, x_leaf_node* high);
+        void settle_prefix(int level, KeyT prefix, bool min_erased, x_leaf_node* low, bool max_erased, x_leaf_node* high);
+        void close_prefixes(int from, KeyT key, x_leaf_node* before, x_leaf_node* after);
+        bool hinted_position(x_fast_trie_const_iterator hint, KeyT key, x_leaf_node*& predecessor, x_leaf_node*& found) const;
+        x_leaf_node* lower_node_from_bottom(const x_fast_node *bottom, KeyT key) const;
+        x_leaf_node* ceiling_node_from_bottom(const x_fast_node *bottom, KeyT key) const;
+        x_leaf_node* lower_node(KeyT key) const;
+        x_leaf_node* ceiling_node(KeyT key) const;
+        x_leaf_node* ceiling_node_near(x_leaf_node* hint, KeyT key) const;
+        x_leaf_node* higher_node(KeyT key) const;
         void remove_leaf(x_leaf_node leaf);
+        template<class InputIt>
+        void reserve_sorted(InputIt first, InputIt last, std::input_iterator_tag);
+        template<class ForwardIt>
+        void reserve_sorted(ForwardIt first, ForwardIt last, std::forward_iterator_tag);
         
     public:
         typedef std::pair<const KeyT, ValueT>   value_type;
-        typedef x_fast_trie_iterator<false>     iterator;
+        typedef x_fast_trie_iterator            iterator;
         typedef x_fast_trie_const_iterator      const_iterator;
         
         x_fast_trie();
+        template<class InputIt>
+        x_fast_trie(sorted_unique_t, InputIt first, InputIt last);
         virtual ~x_fast_trie();
         
         ValueT& at(const KeyT& key);
@@ -73,14 +127,75 @@ namespace kora {
         void clear();
         
         std::pair<iterator, bool> insert(const value_type& value);
+        std::pair<iterator, bool> insert(value_type&& value);
         template<class InputIt>
         void insert(InputIt first, InputIt last);
         void insert(std::initializer_list<value_type> ilist);
         
+        // try_emplace and insert_or_assign search once and build the value
+        // in place, nothing is allocated or constructed if key is present.
+        // emplace has to construct the element to learn its key.
+        template<class... Args>
+        std::pair<iterator, bool> try_emplace(const KeyT& key, Args&&... args);
+        template<class... Args>
+        std::pair<iterator, bool> try_emplace(KeyT&& key, Args&&... args);
+        template<class... Args>
+        std::pair<iterator, bool> emplace(Args&&... args);
+        template<class M>
+        std::pair<iterator, bool> insert_or_assign(const KeyT& key, M&& value);
+        
+        // Inserts next to hint without searching the levels when hint is the
+        // element right before or right after key (end() if key is the new
+        // maximum); any other hint costs one comparison on top of a plain
+        // insert.
+        iterator insert(const_iterator hint, const value_type& value);
+        iterator insert(const_iterator hint, value_type&& value);
+        template<class... Args>
+        iterator try_emplace(const_iterator hint, const KeyT& key, Args&&... args);
+        template<class... Args>
+        iterator try_emplace(const_iterator hint, KeyT&& key, Args&&... args);
+        template<class... Args>
+        iterator emplace_hint(const_iterator hint, Args&&... args);
+        
+        // Inserts key as the new maximum, for keys that only grow such as
+        // timestamps. Throws std::invalid_argument unless key is greater
+        // than every key present. Plain inserts notice new extremes too,
+        // append only saves them the comparison.
+        template<class... Args>
+        iterator append(const KeyT& key, Args&&... args);
+        
+        // Replaces the contents with a range sorted by key, building every
+        // prefix node once. Repeated keys keep their first value; a range
+        // out of order leaves the trie empty and throws std::invalid_argument.
+        template<class InputIt>
+        void build_sorted(InputIt first, InputIt last);
+        
+        // Merges a range sorted by key into the trie, looking up each prefix
+        // node the new keys touch once for the whole range. Keys already
+        // present and repeated keys keep their first value. A range out of
+        // order throws std::invalid_argument and leaves the trie unchanged.
+        // Returns the number of keys added.
+        template<class InputIt>
+        size_t insert_sorted_batch(InputIt first, InputIt last);
+        
         iterator    erase(const_iterator pos);
         iterator    erase(const_iterator first, const_iterator last);
         size_t      erase(const KeyT& key);
         
+        // Remove every key below or above key, returning how many went.
+        // Like range erase they unlink the leaves in one go and visit each
+        // prefix node that loses leaves once.
+        size_t      erase_below(const KeyT& key);
+        size_t      erase_above(const KeyT& key);
+        
+        // Erases the keys of a sorted range, looking up only the prefix
+        // nodes that lose their minimum or maximum, each once for the whole
+        // range. Keys not present are skipped. A range out of order throws
+        // std::invalid_argument and leaves the trie unchanged. Returns the
+        // number of keys erased.
+        template<class InputIt>
+        size_t      erase_sorted_batch(InputIt first, InputIt last);
+        
         size_t count();
         iterator find(const KeyT& key);
         const_iterator find(const KeyT& key) const;
@@ -90,8 +205,41 @@ namespace kora {
         iterator lower_bound(const KeyT& key);
         const_iterator lower_bound(const KeyT& key) const;
         
+        // lower_bound searching from hint, an element near key. Levels above
+        // the longest prefix key shares with the hint's key are known to
+        // exist and are skipped, so the search takes about log log of the
+        // distance between the two in probes, none if hint or its neighbour
+        // is the answer. Any hint is correct, end() one included.
+        iterator lower_bound(const_iterator hint, const KeyT& key);
+        const_iterator lower_bound(const_iterator hint, const KeyT& key) const;
+        
         iterator upper_bound(const KeyT& key);
         const_iterator upper_bound(const KeyT& key) const;
+        
+        // The element with the largest key below key and the one with the
+        // smallest key above it, end() if there is none.
+        iterator predecessor(const KeyT& key);
+        const_iterator predecessor(const KeyT& key) const;
+        
+        iterator successor(const KeyT& key);
+        const_iterator successor(const KeyT& key) const;
+        
+        // Batched find and lower_bound writing one iterator per key to out.
+        // Keys are looked up in groups whose probes are prefetched together,
+        // so the cache misses of a group overlap instead of queueing up.
+        template<class OutputIt>
+        void find_many(const KeyT* keys, size_t n, OutputIt out);
+        template<class OutputIt>
+        void lower_bound_many(const KeyT* keys, size_t n, OutputIt out);
+        
+        // Counters gathered since construction or the last reset_stats(),
+        // always zero with null_stats.
+        trie_stats stats() const;
+        void reset_stats();
+        
+        // Bytes held by the trie, per level of prefix nodes and for the
+        // leaves. Heap bookkeeping is an estimate for glibc malloc.
+        trie_memory memory_usage() const;
     };
 }
 
@@ -8,39 +8,34 @@
 #ifndef _x_fast_trie_impl_h
 #define _x_fast_trie_impl_h
 
-#define __TMPL      template<class KeyT, int Width, class ValueT, class Allocator>
-#define __CLS       kora::x_fast_trie<KeyT, Width, ValueT, Allocator>
+#define __TMPL      template<class KeyT, int Width, class ValueT, class Allocator, class Levels, class Stats>
+#define __CLS       kora::x_fast_trie<KeyT, Width, ValueT, Allocator, Levels, Stats>
 #define __INNER     typename __CLS
 
 #include <stdexcept>
 #include <iterator>
 #include <type_traits>
+#include <tuple>
+#include <vector>
+#include <utility>
 
 __TMPL
-class __CLS::x_fast_trie_const_iterator: public x_fast_trie_iterator<true> {
-private:
-    typedef x_fast_trie_iterator<true> super;
-public:
-    x_fast_trie_const_iterator(const x_fast_trie_iterator<false> it): x_fast_trie_iterator<true>(it._leaf_list, it._node) {}
-};
-
-__TMPL
-kora::x_fast_trie<KeyT, Width, ValueT, Allocator>::x_fast_trie():
-_width(Width),
+__CLS::x_fast_trie():
 _count(0),
 _version(0),
 _leaf_list(0) {
 }
 
+__TMPL
+template<class InputIt>
+__CLS::x_fast_trie(sorted_unique_t, InputIt first, InputIt last):
+x_fast_trie() {
+    build_sorted(first, last);
+}
+
 __TMPL
 __CLS::~x_fast_trie() {
-    iterator it = begin();
-    while(it != end()) {
-        x_leaf_node *node = it._node;
-        it++;
-        _allocator.destroy(node);
-        _allocator.deallocate(node, 1);
-    }
+    destroy_leaves(std::integral_constant<bool, allocator_releases<node_allocator_t>::value>());
 }
 
 __TMPL
@@ -55,29 +50,18 @@ __TMPL
 const ValueT& __CLS::at(const KeyT& key) const {
     const_iterator it = find(key);
     if(it != cend())
-        return (*it)->value();
+        return (*it).second;
     throw std::out_of_range("Specified key does not exist.");
 }
 
 __TMPL
 ValueT& __CLS::operator[](const KeyT& key) {
-    
-    try {
-        return at(key);
-    } catch(std::out_of_range e) {
-        std::pair<iterator, bool> r = insert({key, ValueT()});
-        return (*(r.first)).second;
-    }
+    return (*try_emplace(key).first).second;
 }
 
 __TMPL
 ValueT& __CLS::operator[](KeyT&& key) {
-    try {
-        return at(key);
-    } catch(std::out_of_range e) {
-        std::pair<iterator, bool> r = insert({std::move(key), ValueT()});
-        return (*(r.first)).second;
-    }
+    return (*try_emplace(std::move(key)).first).second;
 }
 
 __TMPL
@@ -104,6 +88,32 @@ __INNER::iterator __CLS::end() {
     return __CLS::iterator(_leaf_list, NULL);
 }
 
+// The largest key, walked down with operator--. The walk ends at rend(),
+// which is end().
+__TMPL
+__INNER::iterator __CLS::rbegin() {
+    if(!_leaf_list)
+        return end();
+    return __CLS::iterator(_leaf_list, _leaf_list->left);
+}
+
+__TMPL
+__INNER::iterator __CLS::rend() {
+    return end();
+}
+
+__TMPL
+__INNER::const_iterator __CLS::rcbegin() const {
+    if(!_leaf_list)
+        return cend();
+    return __CLS::const_iterator(_leaf_list, _leaf_list->left);
+}
+
+__TMPL
+__INNER::const_iterator __CLS::rcend() const {
+    return cend();
+}
+
 __TMPL
 bool __CLS::empty() const {
     return _count == 0;
@@ -122,77 +132,158 @@ size_t __CLS::max_size() const {
 
 __TMPL
 void __CLS::clear() {
-    iterator it = begin();
-    while(it != end()) {
-        x_leaf_node *node = it._node;
-        it++;
-        _allocator.destroy(node);
-        _allocator.deallocate(node);
+    _stats.begin(trie_erase);
+    size_t nodes = _count;
+    for(int i = 0; i < Width; i++) {
+        nodes += _table.size(i);
     }
+    _stats.deallocation(nodes);
+    reset();
+}
+
+// Drops every key, leaving the stats alone.
+__TMPL
+void __CLS::reset() {
+    destroy_leaves(std::integral_constant<bool, allocator_releases<node_allocator_t>::value>());
     _count = 0;
     _version = 0;
     _leaf_list = NULL;
-    for(int i = 0; i < _width; i++) {
-        _table[i].clear();
-    }
+    _table.clear();
 }
 
 __TMPL
 std::pair<__INNER::iterator, bool> __CLS::insert(const value_type &value) {
-    KeyT key = value.first;
-    x_fast_node *bottom_ = bottom(key);
-    x_leaf_node *predecessor = lower_node_from_bottom(bottom_, key);
-    x_leaf_node *pred_right;
-    if(predecessor)
-        pred_right = (x_leaf_node *)(predecessor->right);
+    return try_emplace(value.first, value.second);
+}
+
+__TMPL
+std::pair<__INNER::iterator, bool> __CLS::insert(value_type &&value) {
+    return try_emplace(value.first, std::move(value.second));
+}
+
+__TMPL
+template<class... Args>
+std::pair<__INNER::iterator, bool> __CLS::try_emplace(const KeyT& key, Args&&... args) {
+    return emplace_key(key, std::forward<Args>(args)...);
+}
+
+__TMPL
+template<class... Args>
+std::pair<__INNER::iterator, bool> __CLS::try_emplace(KeyT&& key, Args&&... args) {
+    return emplace_key(std::move(key), std::forward<Args>(args)...);
+}
+
+// Searches for key once and builds the leaf only if key is missing, key
+// being moved into it last.
+__TMPL
+template<class K, class... Args>
+std::pair<__INNER::iterator, bool> __CLS::emplace_key(K&& key, Args&&... args) {
+    _stats.begin(trie_insert);
+    x_leaf_node *found = NULL;
+    x_leaf_node *predecessor;
+    // A new minimum or maximum goes next to an end of the leaf list.
+    if(_leaf_list && key > _leaf_list->left->key())
+        predecessor = _leaf_list->left;
+    else if(_leaf_list && key < _leaf_list->key())
+        predecessor = NULL;
     else
-        pred_right = _leaf_list;
-    if(pred_right && pred_right->key() == key)
-        return { iterator(_leaf_list, pred_right), false };
-    
-    _count++;
-    _version++;
-    x_leaf_node_ptr end_node = _allocator.allocate(1);
-    _allocator.construct(end_node, value);
-    insert_leaf_after(predecessor, end_node);
-    if(!bottom_) {
-        x_fast_node new_fast_node = {end_node, end_node};
-        _table[0].insert({0, new_fast_node});
+        predecessor = lower_node_from_bottom(locate(key, found), key);
+    if(found)
+        return { iterator(_leaf_list, found), false };
+    x_leaf_node *leaf = new_leaf(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+    link_leaf(predecessor, leaf);
+    return { iterator(_leaf_list, leaf), true };
+}
+
+__TMPL
+template<class... Args>
+std::pair<__INNER::iterator, bool> __CLS::emplace(Args&&... args) {
+    _stats.begin(trie_insert);
+    x_leaf_node *leaf = new_leaf(std::forward<Args>(args)...);
+    x_leaf_node *found;
+    const x_fast_node *bottom_ = locate(leaf->key(), found);
+    if(found) {
+        delete_leaf(leaf);
+        return { iterator(_leaf_list, found), false };
     }
-    
-    x_fast_node *old_node = NULL;
-    x_fast_node *current;
-    
-    for(int i = 0; i < _width; i++) {
-        KeyT id_ = key >> (_width - 1 - i) >> 1;
-        lookup_t& table = _table[i];
-        typename lookup_t::iterator current_it = table.find(id_);
-        if(current_it != table.end()) {
-            current = &(current_it->second);
-            x_leaf_node *leaf = NULL;
-            if(current->left && current->left->is_leaf())
-                leaf = dynamic_cast<x_leaf_node *>(current->left);
-            
-            if(leaf && leaf->key() > key)
-                current->left = end_node;
-            else {
-                leaf = dynamic_cast<x_leaf_node *>(current->right);
-                if(leaf && leaf->key() < key)
-                    current->right = end_node;
-            }
-        } else if(old_node) {
-            x_fast_node new_node = { end_node, end_node };
-            current = &(*((table.insert({id_, new_node})).first)).second;
-            if(id_ & 1)
-                old_node->right = current;
-            else
-                old_node->left = current;
-        }
-        else throw std::logic_error("Could not find a proper non-leaf node and a non-leaf node could not be created to link with. File a bug report.");
-        old_node = current;
+    link_leaf(lower_node_from_bottom(bottom_, leaf->key()), leaf);
+    return { iterator(_leaf_list, leaf), true };
+}
+
+__TMPL
+template<class M>
+std::pair<__INNER::iterator, bool> __CLS::insert_or_assign(const KeyT& key, M&& value) {
+    std::pair<iterator, bool> result = try_emplace(key, std::forward<M>(value));
+    if(!result.second)
+        (*result.first).second = std::forward<M>(value);
+    return result;
+}
+
+__TMPL
+__INNER::iterator __CLS::insert(const_iterator hint, const value_type &value) {
+    return try_emplace(hint, value.first, value.second);
+}
+
+__TMPL
+__INNER::iterator __CLS::insert(const_iterator hint, value_type &&value) {
+    return try_emplace(hint, value.first, std::move(value.second));
+}
+
+__TMPL
+template<class... Args>
+__INNER::iterator __CLS::try_emplace(const_iterator hint, const KeyT& key, Args&&... args) {
+    return emplace_key(hint, key, std::forward<Args>(args)...);
+}
+
+__TMPL
+template<class... Args>
+__INNER::iterator __CLS::try_emplace(const_iterator hint, KeyT&& key, Args&&... args) {
+    return emplace_key(hint, std::move(key), std::forward<Args>(args)...);
+}
+
+__TMPL
+template<class K, class... Args>
+__INNER::iterator __CLS::emplace_key(const_iterator hint, K&& key, Args&&... args) {
+    _stats.begin(trie_insert);
+    x_leaf_node *predecessor;
+    x_leaf_node *found;
+    if(!hinted_position(hint, key, predecessor, found))
+        predecessor = lower_node_from_bottom(locate(key, found), key);
+    if(found)
+        return iterator(_leaf_list, found);
+    x_leaf_node *leaf = new_leaf(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+    link_leaf(predecessor, leaf);
+    return iterator(_leaf_list, leaf);
+}
+
+__TMPL
+template<class... Args>
+__INNER::iterator __CLS::emplace_hint(const_iterator hint, Args&&... args) {
+    _stats.begin(trie_insert);
+    x_leaf_node *leaf = new_leaf(std::forward<Args>(args)...);
+    KeyT key = leaf->key();
+    x_leaf_node *predecessor;
+    x_leaf_node *found;
+    if(!hinted_position(hint, key, predecessor, found))
+        predecessor = lower_node_from_bottom(locate(key, found), key);
+    if(found) {
+        delete_leaf(leaf);
+        return iterator(_leaf_list, found);
     }
-    
-    return { iterator(_leaf_list, end_node), true };
+    link_leaf(predecessor, leaf);
+    return iterator(_leaf_list, leaf);
+}
+
+__TMPL
+template<class... Args>
+__INNER::iterator __CLS::append(const KeyT& key, Args&&... args) {
+    _stats.begin(trie_insert);
+    x_leaf_node *last = _leaf_list ? _leaf_list->left : NULL;
+    if(last && !(last->key() < key))
+        throw std::invalid_argument("Appended key is not greater than the maximum.");
+    x_leaf_node *leaf = new_leaf(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+    link_leaf(last, leaf);
+    return iterator(_leaf_list, leaf);
 }
 
 __TMPL
@@ -211,62 +302,353 @@ void __CLS::insert(std::initializer_list<value_type> ilist) {
 }
 
 __TMPL
-__INNER::iterator __CLS::erase(const_iterator pos) {
-    x_leaf_node *leaf = pos._node;
-    KeyT key = leaf->key();
-    x_leaf_node *right = (x_leaf_node *)leaf->right;
-    x_leaf_node *left = (x_leaf_node *)leaf->left;
-    if(right == leaf)
-        _leaf_list = NULL;
-    else {
-        leaf->left->right = right;
-        right->left = leaf->left;
-        if(leaf == _leaf_list)
-            _leaf_list = right;
+template<class InputIt>
+void __CLS::reserve_sorted(InputIt, InputIt, std::input_iterator_tag) {
+}
+
+__TMPL
+template<class ForwardIt>
+void __CLS::reserve_sorted(ForwardIt first, ForwardIt last, std::forward_iterator_tag) {
+    _table.reserve(std::distance(first, last));
+}
+
+__TMPL
+template<class InputIt>
+void __CLS::build_sorted(InputIt first, InputIt last) {
+    reset();
+    _stats.begin(trie_insert);
+    reserve_sorted(first, last, typename std::iterator_traits<InputIt>::iterator_category());
+    
+    // The prefix nodes on the path of the last leaf are still open: each one
+    // remembers its smallest leaf and is written out, with the last leaf as
+    // its largest, once a key with a different prefix at that level arrives.
+    x_leaf_node *open_min[Width];
+    x_leaf_node *previous = NULL;
+    try {
+        for(; first != last; ++first) {
+            KeyT key = (*first).first;
+            int shared = -1;
+            if(previous) {
+                if(key == previous->key())
+                    continue;
+                if(key < previous->key())
+                    throw std::invalid_argument("Range is not sorted by key.");
+                shared = bits::common_prefix<KeyT, Width>(key, previous->key());
+                for(int i = shared + 1; i < Width; i++) {
+                    _table.insert(i, bits::prefix<KeyT, Width>(previous->key(), i), x_fast_node(open_min[i], previous));
+                    _stats.hash_probe();
+                }
+                _stats.allocation(Width - 1 - shared);
+            }
+            
+            x_leaf_node *leaf = new_leaf(*first);
+            leaves::insert_after(_leaf_list, previous, leaf);
+            _count++;
+            for(int i = shared + 1; i < Width; i++) {
+                open_min[i] = leaf;
+            }
+            previous = leaf;
+        }
+        if(!previous)
+            return;
+        for(int i = 0; i < Width; i++) {
+            _table.insert(i, bits::prefix<KeyT, Width>(previous->key(), i), x_fast_node(open_min[i], previous));
+            _stats.hash_probe();
+        }
+        _stats.allocation(Width);
+    } catch(...) {
+        clear();
+        throw;
     }
+    _version++;
+}
+
+__TMPL
+template<class InputIt>
+size_t __CLS::insert_sorted_batch(InputIt first, InputIt last) {
+    _stats.begin(trie_insert);
     
-    bool single = true;
-    for(int i = _width - 1; i >= 0; i--) {
-        KeyT id_ = key >> (_width - 1 - i) >> 1;
-        bool is_from_right = ((key >> (_width - 1 - i)) & 1) == 1;
-        typename lookup_t::iterator current_it = _table[i].find(id_);
-        x_fast_node &current = current_it->second;
-        if(single) {
-            if(is_from_right && (!dynamic_cast<x_leaf_node *>(current.left) || (i == (_width - 1) && ((x_leaf_node *)(current.left))->key() != key))) {
-                
-                current.right = left;
-                single = false;
+    // Build every leaf first so a range out of order can be refused before
+    // the trie changes.
+    std::vector<x_leaf_node *> leaves;
+    try {
+        for(; first != last; ++first) {
+            KeyT key = (*first).first;
+            if(!leaves.empty()) {
+                if(key == leaves.back()->key())
+                    continue;
+                if(key < leaves.back()->key())
+                    throw std::invalid_argument("Range is not sorted by key.");
             }
-            else if(!is_from_right && (!dynamic_cast<x_leaf_node *>(current.right) || (i == (_width - 1) && ((x_leaf_node *)(current.right))->key() != key))) {
-                current.left = right;
-                single = false;
+            leaves.push_back(NULL);
+            leaves.back() = new_leaf(*first);
+        }
+    } catch(...) {
+        for(size_t i = 0; i < leaves.size(); i++) {
+            if(leaves[i])
+                delete_leaf(leaves[i]);
+        }
+        throw;
+    }
+    
+    // Link the leaves while the level table still describes the old keys
+    // only. A new key goes right after the last linked one unless an old
+    // key lies in between, in which case the table finds the largest old
+    // key below it.
+    x_leaf_node *previous = NULL;
+    size_t added = 0;
+    for(size_t i = 0; i < leaves.size(); i++) {
+        x_leaf_node *leaf = leaves[i];
+        KeyT key = leaf->key();
+        x_leaf_node *predecessor = previous;
+        x_leaf_node *next = previous ? previous->right : _leaf_list;
+        if(!next || (previous && next == _leaf_list) || next->key() > key) {
+            _stats.leaf_hop();
+        } else {
+            x_leaf_node *found;
+            x_leaf_node *old = lower_node_from_bottom(locate(key, found), key);
+            if(found) {
+                delete_leaf(leaf);
+                continue;
             }
-            else {
-                _table[i].erase(current_it);
+            if(old && (!previous || old->key() > previous->key()))
+                predecessor = old;
+        }
+        leaves::insert_after(_leaf_list, predecessor, leaf);
+        leaves[added++] = leaf;
+        previous = leaf;
+    }
+    leaves.resize(added);
+    _count += added;
+    if(!added)
+        return 0;
+    _version++;
+    
+    // The new leaves below one prefix are consecutive, so each prefix node
+    // they touch is looked up once, when the run of its leaves ends.
+    x_leaf_node *open_min[Width];
+    for(size_t i = 0; i < added; i++) {
+        int shared = -1;
+        if(i) {
+            shared = bits::common_prefix<KeyT, Width>(leaves[i - 1]->key(), leaves[i]->key());
+            for(int level = shared + 1; level < Width; level++) {
+                publish_prefix(level, open_min[level], leaves[i - 1]);
             }
         }
-        else {
-            if(current.left == leaf)
-                current.left = right;
-            else
-                current.right = left;
+        for(int level = shared + 1; level < Width; level++) {
+            open_min[level] = leaves[i];
         }
     }
+    for(int level = 0; level < Width; level++) {
+        publish_prefix(level, open_min[level], leaves[added - 1]);
+    }
+    return added;
+}
+
+__TMPL
+__INNER::iterator __CLS::erase(const_iterator pos) {
+    _stats.begin(trie_erase);
+    x_leaf_node *leaf = pos._node;
+    KeyT key = leaf->key();
+    x_leaf_node *right = leaf->right;
+    x_leaf_node *left = leaf->left;
+    // The largest leaf has no successor, its right link wraps around.
+    bool last = right == _leaf_list || right == leaf;
+    int shared = -1;
+    if(right != leaf) {
+        // Past either end the list wraps around to a leaf sharing less.
+        int left_shared = bits::common_prefix<KeyT, Width>(key, left->key());
+        int right_shared = bits::common_prefix<KeyT, Width>(key, right->key());
+        shared = left_shared > right_shared ? left_shared : right_shared;
+    }
+    leaves::unlink(_leaf_list, leaf);
+    
+    // Prefix nodes below the longest prefix shared with a neighbour hold
+    // only this leaf and go away without being looked up. The others hand
+    // their minimum or maximum over to the leaf's neighbour; once a node
+    // neither starts nor ends with the leaf, no ancestor does either.
+    _table.erase_path(key, shared + 1, Width);
+    _stats.hash_probe(Width - 1 - shared);
+    _stats.deallocation(Width - 1 - shared);
+    for(int i = shared; i >= 0; i--) {
+        KeyT id_ = bits::prefix<KeyT, Width>(key, i);
+        x_fast_node *current = _table.find(i, id_);
+        _stats.hash_probe();
+        if(current->left == leaf)
+            current->left = right;
+        else if(current->right == leaf)
+            current->right = left;
+        else
+            break;
+    }
     
     _count--;
     _version++;
-    _allocator.destroy(leaf);
-    _allocator.deallocate(leaf, 1);
+    delete_leaf(leaf);
+    if(last)
+        return end();
     return iterator(_leaf_list, right);
 }
 
+__TMPL
+size_t __CLS::erase(const KeyT& key) {
+    iterator it = find(key);
+    if(it == end())
+        return 0;
+    erase(it);
+    return 1;
+}
+
 __TMPL
 __INNER::iterator __CLS::erase(const_iterator first, const_iterator last) {
-    while(first != last && first != cend()) {
-        first = erase(first);
+    if(first == last)
+        return iterator(_leaf_list, last._node);
+    if(first._node == _leaf_list && !last._node) {
+        clear();
+        return end();
+    }
+    
+    // The span is cut out of the circular list between its outer
+    // neighbours, before and after are the survivors next to it, NULL if
+    // the span reaches an end.
+    _stats.begin(trie_erase);
+    x_leaf_node *span_first = first._node;
+    x_leaf_node *span_last = last._node ? last._node->left : _leaf_list->left;
+    x_leaf_node *before = span_first == _leaf_list ? NULL : span_first->left;
+    x_leaf_node *after = last._node;
+    span_first->left->right = span_last->right;
+    span_last->right->left = span_first->left;
+    if(!before)
+        _leaf_list = after;
+    
+    // Consecutive keys of the span stop sharing the prefixes below their
+    // common one; each such prefix is done with once the walk leaves it.
+    x_leaf_node *leaf = span_first;
+    KeyT previous = leaf->key();
+    size_t erased = 0;
+    for(;;) {
+        x_leaf_node *next = leaf == span_last ? NULL : leaf->right;
+        KeyT key = leaf->key();
+        if(erased)
+            close_prefixes(bits::common_prefix<KeyT, Width>(previous, key) + 1, previous, before, after);
+        previous = key;
+        delete_leaf(leaf);
+        erased++;
+        if(!next)
+            break;
+        leaf = next;
+    }
+    close_prefixes(0, previous, before, after);
+    
+    _count -= erased;
+    _version++;
+    return iterator(_leaf_list, after);
+}
+
+__TMPL
+template<class InputIt>
+size_t __CLS::erase_sorted_batch(InputIt first, InputIt last) {
+    _stats.begin(trie_erase);
+    
+    // Read the whole range first so one out of order is refused before the
+    // trie changes.
+    std::vector<KeyT> keys;
+    for(; first != last; ++first) {
+        KeyT key = *first;
+        if(!keys.empty()) {
+            if(key == keys.back())
+                continue;
+            if(key < keys.back())
+                throw std::invalid_argument("Range is not sorted by key.");
+        }
+        keys.push_back(key);
     }
     
-    return first;
+    // Leaves are unlinked in key order, so an erased leaf's left neighbour
+    // is the survivor before it and its right one the survivor after it or
+    // the next erased leaf. A prefix node whose run of erased leaves has a
+    // survivor of the same prefix on both sides keeps its bounds and is
+    // never looked up. low is the first survivor inside the run, for the
+    // nodes losing their minimum.
+    bool min_erased[Width];
+    x_leaf_node *low[Width];
+    x_leaf_node *previous = NULL;
+    x_leaf_node *previous_left = NULL;
+    x_leaf_node *previous_right = NULL;
+    size_t erased = 0;
+    for(size_t i = 0; i <= keys.size(); i++) {
+        x_leaf_node *leaf = NULL;
+        if(i < keys.size()) {
+            x_fast_node *node = _table.find(Width - 1, keys[i] >> 1);
+            _stats.hash_probe();
+            if(!node)
+                continue;
+            leaf = (keys[i] & 1) == 1 ? node->right : node->left;
+            if(leaf->key() != keys[i])
+                continue;
+        }
+        
+        int shared = -1;
+        if(previous) {
+            KeyT key = previous->key();
+            x_leaf_node *gap = previous_right == leaf ? NULL : previous_right;
+            if(leaf)
+                shared = bits::common_prefix<KeyT, Width>(key, leaf->key());
+            for(int level = shared + 1; level < Width; level++) {
+                KeyT prefix = bits::prefix<KeyT, Width>(key, level);
+                bool max_erased = !gap || bits::prefix<KeyT, Width>(gap->key(), level) != prefix;
+                if(min_erased[level] && !low[level] && !max_erased)
+                    low[level] = gap;
+                if(min_erased[level] || max_erased)
+                    settle_prefix(level, prefix, min_erased[level], low[level], max_erased, previous_left);
+            }
+            if(gap) {
+                for(int level = 0; level <= shared; level++) {
+                    if(min_erased[level] && !low[level])
+                        low[level] = gap;
+                }
+            }
+            delete_leaf(previous);
+        }
+        if(!leaf)
+            break;
+        
+        KeyT key = leaf->key();
+        previous = leaf;
+        previous_left = leaf == _leaf_list ? NULL : leaf->left;
+        previous_right = leaf->right == _leaf_list ? NULL : leaf->right;
+        for(int level = shared + 1; level < Width; level++) {
+            min_erased[level] = !previous_left || bits::prefix<KeyT, Width>(previous_left->key(), level) != bits::prefix<KeyT, Width>(key, level);
+            low[level] = NULL;
+        }
+        if(leaf->right == leaf)
+            _leaf_list = NULL;
+        else {
+            leaf->left->right = leaf->right;
+            leaf->right->left = leaf->left;
+            if(leaf == _leaf_list)
+                _leaf_list = leaf->right;
+        }
+        erased++;
+    }
+    _count -= erased;
+    if(erased)
+        _version++;
+    return erased;
+}
+
+__TMPL
+size_t __CLS::erase_below(const KeyT& key) {
+    size_t count = _count;
+    erase(cbegin(), lower_bound(key));
+    return count - _count;
+}
+
+__TMPL
+size_t __CLS::erase_above(const KeyT& key) {
+    size_t count = _count;
+    erase(upper_bound(key), cend());
+    return count - _count;
 }
 
 __TMPL
@@ -276,17 +658,17 @@ size_t __CLS::count() {
 
 __TMPL
 __INNER::iterator __CLS::find(const KeyT &key) {
-    lookup_t& table = _table[_width - 1];
-    __INNER::lookup_t::iterator node_it = table.find(key >> 1);
-    if(node_it != table.end()) {
-        x_fast_node &node = node_it->second;
+    _stats.begin(trie_lookup);
+    _stats.hash_probe();
+    x_fast_node *node = _table.find(Width - 1, key >> 1);
+    if(node) {
         if((key & 1) == 1) {
-            x_leaf_node *right_ptr = (x_leaf_node *)node.right;
-            if(right_ptr && right_ptr->key() == key)
+            x_leaf_node *right_ptr = node->right;
+            if(right_ptr->key() == key)
                 return iterator(_leaf_list, right_ptr);
         } else {
-            x_leaf_node *left_ptr = (x_leaf_node *)node.left;
-            if(left_ptr && left_ptr->key() == key)
+            x_leaf_node *left_ptr = node->left;
+            if(left_ptr->key() == key)
                 return iterator(_leaf_list, left_ptr);
         }
     }
@@ -296,18 +678,17 @@ __INNER::iterator __CLS::find(const KeyT &key) {
 
 __TMPL
 __INNER::const_iterator __CLS::find(const KeyT &key) const {
-    const lookup_t& lookup = _table[_width - 1];
-    __INNER::lookup_t::const_iterator node_it = lookup.find(key >> 1);
-    if(node_it != lookup.end()) {
-        const x_fast_node &node = (*node_it).second;
+    _stats.begin(trie_lookup);
+    _stats.hash_probe();
+    const x_fast_node *node = _table.find(Width - 1, key >> 1);
+    if(node) {
         if((key & 1) == 1) {
-            const x_leaf_node *right_ptr = (x_leaf_node *)node.right;
-            if(right_ptr && right_ptr->key == key) {
-                return const_iterator(right_ptr);
-            }
+            x_leaf_node *right_ptr = node->right;
+            if(right_ptr->key() == key)
+                return const_iterator(_leaf_list, right_ptr);
         } else {
-            const x_leaf_node *left_ptr = (x_leaf_node *)node.left;
-            if(left_ptr && left_ptr->key() == key)
+            x_leaf_node *left_ptr = node->left;
+            if(left_ptr->key() == key)
                 return const_iterator(_leaf_list, left_ptr);
         }
     }
@@ -316,166 +697,526 @@ __INNER::const_iterator __CLS::find(const KeyT &key) const {
 }
 
 __TMPL
-__INNER::x_fast_node* __CLS::bottom(KeyT key) {
-    int l = 0;
-    int h = _width;
-    x_fast_node *correct_node_ptr = NULL;
-    do {
-        int j = (l + h) / 2;
-        const KeyT ancestor = key >> (_width - 1 - j) >> 1;
-        lookup_t& table = _table[j];
-        auto temp_node_it = table.find(ancestor);
-        if(temp_node_it != table.end()) {
-            l = j + 1;
-            correct_node_ptr = &((*temp_node_it).second);
-        } else {
-            h = j;
+std::pair<__INNER::iterator, __INNER::iterator> __CLS::equal_range(const KeyT &key) {
+    iterator it = find(key);
+    if(it == end()) {
+        it = lower_bound(key);
+        return { it, it };
+    }
+    iterator next = it;
+    return { it, ++next };
+}
+
+__TMPL
+std::pair<__INNER::const_iterator, __INNER::const_iterator> __CLS::equal_range(const KeyT &key) const {
+    const_iterator it = find(key);
+    if(it == cend()) {
+        it = lower_bound(key);
+        return { it, it };
+    }
+    const_iterator next = it;
+    return { it, ++next };
+}
+
+__TMPL
+__INNER::iterator __CLS::lower_bound(const KeyT &key) {
+    _stats.begin(trie_lookup);
+    return iterator(_leaf_list, ceiling_node(key));
+}
+
+__TMPL
+__INNER::const_iterator __CLS::lower_bound(const KeyT &key) const {
+    _stats.begin(trie_lookup);
+    return const_iterator(_leaf_list, ceiling_node(key));
+}
+
+__TMPL
+__INNER::iterator __CLS::lower_bound(const_iterator hint, const KeyT &key) {
+    _stats.begin(trie_lookup);
+    return iterator(_leaf_list, ceiling_node_near(hint._node, key));
+}
+
+__TMPL
+__INNER::const_iterator __CLS::lower_bound(const_iterator hint, const KeyT &key) const {
+    _stats.begin(trie_lookup);
+    return const_iterator(_leaf_list, ceiling_node_near(hint._node, key));
+}
+
+__TMPL
+__INNER::iterator __CLS::upper_bound(const KeyT &key) {
+    _stats.begin(trie_lookup);
+    return iterator(_leaf_list, higher_node(key));
+}
+
+__TMPL
+__INNER::const_iterator __CLS::upper_bound(const KeyT &key) const {
+    _stats.begin(trie_lookup);
+    return const_iterator(_leaf_list, higher_node(key));
+}
+
+__TMPL
+__INNER::iterator __CLS::predecessor(const KeyT &key) {
+    _stats.begin(trie_lookup);
+    return iterator(_leaf_list, lower_node(key));
+}
+
+__TMPL
+__INNER::const_iterator __CLS::predecessor(const KeyT &key) const {
+    _stats.begin(trie_lookup);
+    return const_iterator(_leaf_list, lower_node(key));
+}
+
+__TMPL
+__INNER::iterator __CLS::successor(const KeyT &key) {
+    _stats.begin(trie_lookup);
+    return iterator(_leaf_list, higher_node(key));
+}
+
+__TMPL
+__INNER::const_iterator __CLS::successor(const KeyT &key) const {
+    _stats.begin(trie_lookup);
+    return const_iterator(_leaf_list, higher_node(key));
+}
+
+__TMPL
+template<class OutputIt>
+void __CLS::find_many(const KeyT* keys, size_t n, OutputIt out) {
+    _stats.begin(trie_lookup, n);
+    x_leaf_node *candidates[batch_size];
+    for(size_t base = 0; base < n; base += batch_size) {
+        const KeyT *group = keys + base;
+        size_t group_size = batch_size;
+        if(n - base < group_size)
+            group_size = n - base;
+        for(size_t k = 0; k < group_size; k++) {
+            _table.prefetch(Width - 1, group[k] >> 1);
+        }
+        for(size_t k = 0; k < group_size; k++) {
+            x_fast_node *node = _table.find(Width - 1, group[k] >> 1);
+            _stats.hash_probe();
+            candidates[k] = NULL;
+            if(node) {
+                candidates[k] = (group[k] & 1) == 1 ? node->right : node->left;
+                bits::prefetch(candidates[k]);
+            }
+        }
+        for(size_t k = 0; k < group_size; k++) {
+            if(candidates[k] && candidates[k]->key() == group[k])
+                *out = iterator(_leaf_list, candidates[k]);
+            else
+                *out = end();
+            ++out;
         }
-    } while(l < h);
-    return correct_node_ptr;
+    }
 }
 
 __TMPL
-void __CLS::insert_leaf_after(x_fast_node *marker, x_leaf_node *new_leaf) {
-    if(marker == NULL) {
-        if(_leaf_list == NULL) {
-            _leaf_list = new_leaf;
-            new_leaf->left = new_leaf;
-            new_leaf->right = new_leaf;
-        } else {
-            _leaf_list->left->right = new_leaf;
-            new_leaf->left = _leaf_list->left;
-            new_leaf->right = _leaf_list;
-            _leaf_list->left = new_leaf;
-            _leaf_list = new_leaf;
+template<class OutputIt>
+void __CLS::lower_bound_many(const KeyT* keys, size_t n, OutputIt out) {
+    // The binary search of bottom() run for a whole group at once, one
+    // level probe per key and round.
+    int low[batch_size];
+    int high[batch_size];
+    const x_fast_node *deepest[batch_size];
+    _stats.begin(trie_lookup, n);
+    for(size_t base = 0; base < n; base += batch_size) {
+        const KeyT *group = keys + base;
+        size_t group_size = batch_size;
+        if(n - base < group_size)
+            group_size = n - base;
+        for(size_t k = 0; k < group_size; k++) {
+            low[k] = 0;
+            high[k] = Width;
+            deepest[k] = NULL;
+        }
+        for(bool searching = true; searching;) {
+            searching = false;
+            for(size_t k = 0; k < group_size; k++) {
+                if(low[k] < high[k]) {
+                    int j = (low[k] + high[k]) / 2;
+                    _table.prefetch(j, bits::prefix<KeyT, Width>(group[k], j));
+                    searching = true;
+                }
+            }
+            for(size_t k = 0; k < group_size; k++) {
+                if(low[k] < high[k]) {
+                    int j = (low[k] + high[k]) / 2;
+                    const x_fast_node *node = _table.find(j, bits::prefix<KeyT, Width>(group[k], j));
+                    _stats.level_search();
+                    _stats.hash_probe();
+                    if(node) {
+                        low[k] = j + 1;
+                        deepest[k] = node;
+                    } else {
+                        high[k] = j;
+                    }
+                }
+            }
+        }
+        for(size_t k = 0; k < group_size; k++) {
+            if(deepest[k]) {
+                bits::prefetch(deepest[k]->left);
+                bits::prefetch(deepest[k]->right);
+            }
+        }
+        for(size_t k = 0; k < group_size; k++) {
+            *out = iterator(_leaf_list, ceiling_node_from_bottom(deepest[k], group[k]));
+            ++out;
+        }
+    }
+}
+
+__TMPL
+const __INNER::x_fast_node* __CLS::bottom(KeyT key) const {
+    counted_levels levels = { _table, _stats };
+    return bits::level_search<KeyT, Width, 0, Width>::deepest(levels, key, (const x_fast_node *)NULL);
+}
+
+__TMPL
+const __INNER::x_fast_node* __CLS::counted_levels::find(int level, KeyT prefix) const {
+    stats.level_search();
+    stats.hash_probe();
+    return table.find(level, prefix);
+}
+
+__TMPL
+kora::trie_stats __CLS::stats() const {
+    return _stats.snapshot();
+}
+
+__TMPL
+void __CLS::reset_stats() {
+    _stats.reset();
+}
+
+__TMPL
+kora::trie_memory __CLS::memory_usage() const {
+    trie_memory memory;
+    memory.levels.resize(Width);
+    memory.shared_table_bytes = _table.memory_usage(&memory.levels[0]);
+    memory.leaf_count = _count;
+    memory.leaf_bytes = _count * sizeof(x_leaf_node);
+    memory.allocator_overhead = allocator_overhead(std::integral_constant<bool, allocator_releases<node_allocator_t>::value>());
+    memory.object_bytes = sizeof(*this);
+    return memory;
+}
+
+__TMPL
+size_t __CLS::allocator_overhead(std::false_type) const {
+    return _count * (bits::heap_block_bytes(sizeof(x_leaf_node)) - sizeof(x_leaf_node));
+}
+
+__TMPL
+size_t __CLS::allocator_overhead(std::true_type) const {
+    // Everything the leaf arena reserved that no live leaf occupies.
+    size_t reserved = _allocator.reserved_bytes();
+    size_t used = _count * sizeof(x_leaf_node);
+    return reserved > used ? reserved - used : 0;
+}
+
+// The parent prefix of key is the deepest one there can be and tells at
+// once whether key is present, the level search only runs if it is missing.
+__TMPL
+const __INNER::x_fast_node* __CLS::locate(KeyT key, x_leaf_node*& found) const {
+    found = NULL;
+    _stats.hash_probe();
+    const x_fast_node *parent = _table.find(Width - 1, key >> 1);
+    if(!parent)
+        return bottom(key);
+    x_leaf_node *candidate = (key & 1) == 1 ? parent->right : parent->left;
+    if(candidate->key() == key)
+        found = candidate;
+    return parent;
+}
+
+__TMPL
+template<class... Args>
+__INNER::x_leaf_node* __CLS::new_leaf(Args&&... args) {
+    return leaves::create(_allocator, _stats, std::forward<Args>(args)...);
+}
+
+__TMPL
+void __CLS::delete_leaf(x_leaf_node* leaf) {
+    leaves::destroy(_allocator, _stats, leaf);
+}
+
+// Links a new leaf right after predecessor, NULL if it becomes the first.
+// Prefixes the leaf shares with neither neighbour are held by no other
+// leaf, so levels below the longest prefix shared with a neighbour get a
+// node each without being looked up.
+__TMPL
+void __CLS::link_leaf(x_leaf_node* predecessor, x_leaf_node* leaf) {
+    KeyT key = leaf->key();
+    int shared = -1;
+    if(_leaf_list) {
+        // Past either end the list wraps around to a leaf sharing less.
+        x_leaf_node *successor = predecessor ? predecessor->right : _leaf_list;
+        int left = bits::common_prefix<KeyT, Width>(key, successor->left->key());
+        int right = bits::common_prefix<KeyT, Width>(key, successor->key());
+        shared = left > right ? left : right;
+    }
+    _count++;
+    _version++;
+    leaves::insert_after(_leaf_list, predecessor, leaf);
+    
+    _table.insert_path(key, shared + 1, Width, x_fast_node(leaf, leaf));
+    _stats.hash_probe(Width - 1 - shared);
+    _stats.allocation(Width - 1 - shared);
+    
+    // The shared prefixes may get a new minimum or maximum. Once a prefix
+    // node already brackets the key, every ancestor does too.
+    for(int i = shared; i >= 0; i--) {
+        x_fast_node *current = _table.find(i, bits::prefix<KeyT, Width>(key, i));
+        _stats.hash_probe();
+        if(current->left->key() > key)
+            current->left = leaf;
+        else if(current->right->key() < key)
+            current->right = leaf;
+        else
+            break;
+    }
+}
+
+// Merges the new leaves low to high, all with the same prefix at level,
+// into that prefix's node.
+__TMPL
+void __CLS::publish_prefix(int level, x_leaf_node* low, x_leaf_node* high) {
+    KeyT prefix = bits::prefix<KeyT, Width>(low->key(), level);
+    x_fast_node *node = _table.find(level, prefix);
+    _stats.hash_probe();
+    if(!node) {
+        _table.insert(level, prefix, x_fast_node(low, high));
+        _stats.hash_probe();
+        _stats.allocation();
+        return;
+    }
+    if(low->key() < node->left->key())
+        node->left = low;
+    if(high->key() > node->right->key())
+        node->right = high;
+}
+
+// Updates the prefix node at level after a run of its leaves is erased:
+// an erased minimum hands over to low, the first survivor of the prefix,
+// and an erased maximum to high, the last one. Without low nothing of the
+// prefix survives and the node goes.
+__TMPL
+void __CLS::settle_prefix(int level, KeyT prefix, bool min_erased, x_leaf_node* low, bool max_erased, x_leaf_node* high) {
+    if(min_erased && !low) {
+        _table.erase(level, prefix);
+        _stats.hash_probe();
+        _stats.deallocation();
+        return;
+    }
+    x_fast_node *node = _table.find(level, prefix);
+    _stats.hash_probe();
+    if(min_erased)
+        node->left = low;
+    if(max_erased)
+        node->right = high;
+}
+
+// Settles the prefixes of an erased key at levels from and deeper, which no
+// later key of the erased span shares. A prefix also holding a survivor
+// next to the span keeps its node with that survivor as its new bound; one
+// holding neither survivor held erased leaves only and goes.
+__TMPL
+void __CLS::close_prefixes(int from, KeyT key, x_leaf_node* before, x_leaf_node* after) {
+    int before_shared = before ? bits::common_prefix<KeyT, Width>(before->key(), key) : -1;
+    int after_shared = after ? bits::common_prefix<KeyT, Width>(after->key(), key) : -1;
+    for(int i = from; i < Width; i++) {
+        bool keeps_before = i <= before_shared;
+        bool keeps_after = i <= after_shared;
+        if(keeps_before && keeps_after)
+            continue;
+        KeyT prefix = bits::prefix<KeyT, Width>(key, i);
+        _stats.hash_probe();
+        if(!keeps_before && !keeps_after) {
+            _table.erase(i, prefix);
+            _stats.deallocation();
+            continue;
         }
+        x_fast_node *node = _table.find(i, prefix);
+        if(!keeps_before)
+            node->left = after;
+        else
+            node->right = before;
+    }
+}
+
+// Finds where key goes when hint is its neighbour: predecessor is the leaf
+// to link the key after and found the leaf already holding it. Returns
+// false if hint is not next to key.
+__TMPL
+bool __CLS::hinted_position(const_iterator hint, KeyT key, x_leaf_node*& predecessor, x_leaf_node*& found) const {
+    found = NULL;
+    predecessor = NULL;
+    if(!_leaf_list)
+        return true;
+    x_leaf_node *before;
+    x_leaf_node *after;
+    x_leaf_node *node = hint._node;
+    _stats.leaf_hop();
+    if(!node) {
+        before = _leaf_list->left;
+        after = NULL;
+    } else if(node->key() < key) {
+        before = node;
+        after = node->right == _leaf_list ? NULL : node->right;
     } else {
-        x_fast_node *right_node = marker->right;
-        marker->right = new_leaf;
-        new_leaf->left = marker;
-        new_leaf->right = right_node;
-        right_node->left = new_leaf;
+        before = node == _leaf_list ? NULL : node->left;
+        after = node;
+    }
+    if(after && after->key() == key)
+        found = after;
+    else if(before && before->key() == key)
+        found = before;
+    else if((before && before->key() > key) || (after && after->key() < key))
+        return false;
+    predecessor = before;
+    return true;
+}
+
+__TMPL
+void __CLS::destroy_leaves(std::false_type) {
+    x_leaf_node *leaf = _leaf_list;
+    for(size_t i = 0; i < _count; i++) {
+        x_leaf_node *next = leaf->right;
+        node_traits_t::destroy(_allocator, leaf);
+        node_traits_t::deallocate(_allocator, leaf, 1);
+        leaf = next;
+    }
+}
+
+__TMPL
+void __CLS::destroy_leaves(std::true_type) {
+    // The allocator hands its chunks back in one go, the leaf list only has
+    // to be walked when values need their destructors run.
+    if(!std::is_trivially_destructible<value_type>::value) {
+        x_leaf_node *leaf = _leaf_list;
+        for(size_t i = 0; i < _count; i++) {
+            x_leaf_node *next = leaf->right;
+            node_traits_t::destroy(_allocator, leaf);
+            leaf = next;
+        }
     }
+    _allocator.release();
+}
+
+// Leaves below the deepest node holding a prefix of key lie on one side of
+// key unless key itself is there, so the neighbours of key are among that
+// node's minimum and maximum and their outer neighbours.
+__TMPL
+__INNER::x_leaf_node* __CLS::lower_node_from_bottom(const x_fast_node *bottom, KeyT key) const {
+    if(!bottom)
+        return NULL;
+    
+    if(bottom->right->key() < key)
+        return bottom->right;
+    if(bottom->left->key() < key)
+        return bottom->left;
+    _stats.leaf_hop();
+    if(bottom->left->left->key() < key)
+        return bottom->left->left;
+    return NULL;
 }
 
 __TMPL
-__INNER::x_leaf_node* __CLS::lower_node_from_bottom(x_fast_node *bottom, KeyT key) {
+__INNER::x_leaf_node* __CLS::ceiling_node_from_bottom(const x_fast_node *bottom, KeyT key) const {
     if(!bottom)
         return NULL;
     
-    x_leaf_node *leaf = dynamic_cast<x_leaf_node *>(bottom->right);
-    if(leaf && leaf->key() < key)
-        return leaf;
-    leaf = dynamic_cast<x_leaf_node *>(bottom->left);
-    if(leaf && leaf->key() < key)
-        return leaf;
-    leaf = dynamic_cast<x_leaf_node *>(bottom->left->left);
-    if(leaf && leaf->key() < key)
-        return leaf;
+    if(bottom->left->key() >= key)
+        return bottom->left;
+    if(bottom->right->key() >= key)
+        return bottom->right;
+    _stats.leaf_hop();
+    if(bottom->right->right != _leaf_list)
+        return bottom->right->right;
     return NULL;
 }
 
 __TMPL
-__INNER::x_leaf_node* __CLS::lower_node(KeyT key) {
-    x_fast_node *ancestor = bottom(key);
-    return lower_node_from_bottom(ancestor, key);
+__INNER::x_leaf_node* __CLS::lower_node(KeyT key) const {
+    return lower_node_from_bottom(bottom(key), key);
+}
+
+__TMPL
+__INNER::x_leaf_node* __CLS::ceiling_node(KeyT key) const {
+    return ceiling_node_from_bottom(bottom(key), key);
+}
+
+// The prefix key shares with hint has a node, hint being below it, so the
+// level search only covers the levels deeper than that. Without a deeper
+// prefix of key that node is the bottom one.
+__TMPL
+__INNER::x_leaf_node* __CLS::ceiling_node_near(x_leaf_node* hint, KeyT key) const {
+    if(!hint || !_leaf_list)
+        return ceiling_node(key);
+    _stats.leaf_hop();
+    if(hint->key() >= key) {
+        if(hint == _leaf_list || hint->left->key() < key)
+            return hint;
+    } else {
+        x_leaf_node *next = hint->right == _leaf_list ? NULL : hint->right;
+        if(!next || next->key() >= key)
+            return next;
+    }
+    
+    int shared = bits::common_prefix<KeyT, Width>(hint->key(), key);
+    int low = shared + 1;
+    int high = Width;
+    const x_fast_node *deepest = NULL;
+    while(low < high) {
+        int j = (low + high) / 2;
+        const x_fast_node *node = _table.find(j, bits::prefix<KeyT, Width>(key, j));
+        _stats.level_search();
+        _stats.hash_probe();
+        if(node) {
+            low = j + 1;
+            deepest = node;
+        } else {
+            high = j;
+        }
+    }
+    if(!deepest) {
+        deepest = _table.find(shared, bits::prefix<KeyT, Width>(key, shared));
+        _stats.hash_probe();
+    }
+    return ceiling_node_from_bottom(deepest, key);
 }
 
 __TMPL
-__INNER::x_leaf_node* __CLS::higher_node(KeyT key) {
-    x_fast_node *ancestor = bottom(key);
-    if(!ancestor)
+__INNER::x_leaf_node* __CLS::higher_node(KeyT key) const {
+    x_leaf_node *ceiling = ceiling_node(key);
+    if(!ceiling || ceiling->key() != key)
+        return ceiling;
+    _stats.leaf_hop();
+    if(ceiling->right == _leaf_list)
         return NULL;
-    x_leaf_node *leaf = dynamic_cast<x_leaf_node *>(ancestor->left);
-    if(leaf && leaf->key > key)
-        return leaf;
-    leaf = dynamic_cast<x_leaf_node *>(ancestor->right);
-    if(leaf && leaf->key > key)
-        return leaf;
-    leaf = dynamic_cast<x_leaf_node *>(ancestor->right->right);
-    if(leaf && leaf->key > key)
-        return leaf;
-    return NULL;
+    return ceiling->right;
 }
 
+// Every prefix node links the smallest (left) and the largest (right) leaf
+// below it, so nodes never point at each other and the level table is free
+// to move them around. Both links always point at leaves, which keeps the
+// node two plain pointers without any type tag.
 __TMPL
 struct __CLS::x_fast_node {
-    x_fast_node* left;
-    x_fast_node* right;
+    x_leaf_node* left;
+    x_leaf_node* right;
     
     x_fast_node() {
         left = NULL;
         right = NULL;
     }
     
-    x_fast_node(x_fast_node *l, x_fast_node *r) {
+    x_fast_node(x_leaf_node *l, x_leaf_node *r) {
         left = l;
         right = r;
     }
-    
-    virtual bool is_leaf() { return false; }
-};
-
-__TMPL
-struct __CLS::x_leaf_node: public __CLS::x_fast_node {
-    std::pair<const KeyT, ValueT> key_value;
-    
-    x_leaf_node(const value_type& value): x_fast_node(), key_value(value)
-    {}
-    
-    virtual bool is_leaf() { return true; }
-    const KeyT& key() const { return key_value.first; }
-    ValueT& value() { return key_value.second; }
-    const ValueT& value() const { return key_value.second; }
-};
-
-__TMPL
-template<bool IsConst>
-class __CLS::x_fast_trie_iterator : public std::iterator<std::bidirectional_iterator_tag, value_type, size_t> {
-    
-protected:
-    typedef typename std::conditional<IsConst, const value_type, value_type>::type ValueTypeT;
-    
-    friend class __CLS;
-    __CLS::x_leaf_node *_node;
-    __CLS::x_leaf_node *_leaf_list;
-    x_fast_trie_iterator(x_leaf_node* leaf_list, x_leaf_node* node) {
-        _node = node;
-        _leaf_list = leaf_list;
-    }
-public:
-    ValueTypeT& operator*() const { return _node->key_value; }
-    ValueTypeT* operator->() const { return &(_node->key_value); }
-    const x_fast_trie_iterator<IsConst>& operator++() {
-        _node = (x_leaf_node *)_node->right;
-        if(_node == _leaf_list) _node = NULL;
-        return *this;
-    }
-    x_fast_trie_iterator<IsConst> operator++(int) {
-        ++(*this);
-        return *this;
-    }
-    const x_fast_trie_iterator<IsConst>& operator--() {
-        _node = (x_leaf_node *)_node->left;
-        if(_node == _leaf_list->left) _node = NULL;
-        return *this;
-    }
-    x_fast_trie_iterator<IsConst> operator--(int) {
-        --(*this);
-        return *this;
-    }
-    bool operator==(const x_fast_trie_iterator<IsConst>& other) const {
-        return _node == other._node;
-    }
-    bool operator!=(const x_fast_trie_iterator<IsConst>& other) const {
-        return _node != other._node;
-    }
 };
 
-
-
-
-
 #undef __INNER
 #undef __CLS
 #undef __TMPL
@@ -0,0 +1,251 @@
+//
+//  x_fast_trie_levels.h
+//
+//  Level storage policies for kora::x_fast_trie.
+//  Author: Anil Anar.
+//
+
+#ifndef _x_fast_trie_levels_h
+#define _x_fast_trie_levels_h
+
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "trie_bits.h"
+#include "trie_probing.h"
+#include "trie_memory.h"
+#include "slab_allocator.h"
+
+namespace kora {
+    // A level table maps (level, prefix) to the x_fast_node of that prefix.
+    // Pointers it hands out stay valid until the next insert or erase.
+    // reserve(keys) makes room for the prefixes of that many distinct keys,
+    // prefetch(level, prefix) starts loading the memory a find would touch.
+    // memory_usage(levels) fills in one level_memory per level and returns
+    // the bytes shared by all levels. insert_path(key, from, to, node) puts
+    // node under the prefix of key at each level in [from, to), none of
+    // them present yet, and erase_path(key, from, to) takes them out again;
+    // they serve tries whose level i holds the i-bit prefixes.
+
+    // One std::unordered_map per level. Every level gets a copy of the same
+    // allocator, so the levels share a single slab_arena.
+    template<class KeyT, class NodeT, int Width, class Allocator>
+    class hashed_level_table {
+    private:
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<std::pair<const KeyT, NodeT>> allocator_t;
+        typedef std::unordered_map<KeyT, NodeT, std::hash<KeyT>, std::equal_to<KeyT>, allocator_t> level_t;
+
+        allocator_t _allocator;
+        level_t _levels[Width];
+
+        template<size_t... Levels>
+        hashed_level_table(std::index_sequence<Levels...>);
+        const allocator_t& level_allocator(size_t level) const;
+        size_t arena_overhead(std::false_type, size_t used) const;
+        size_t arena_overhead(std::true_type, size_t used) const;
+
+    public:
+        hashed_level_table();
+
+        NodeT* find(int level, KeyT prefix);
+        const NodeT* find(int level, KeyT prefix) const;
+        NodeT* insert(int level, KeyT prefix, const NodeT& node);
+        void erase(int level, KeyT prefix);
+        void prefetch(int level, KeyT prefix) const;
+        void insert_path(KeyT key, int from, int to, const NodeT& node);
+        void erase_path(KeyT key, int from, int to);
+
+        size_t size(int level) const;
+        void clear();
+        void reserve(size_t keys);
+
+        double average_probe_length() const;
+        size_t memory_usage(level_memory* levels) const;
+    };
+
+    // All levels in a single open-addressing table keyed by (level, prefix),
+    // using Robin Hood probing with backward-shift deletion and inline nodes.
+    template<class KeyT, class NodeT, int Width, class Allocator>
+    class flat_level_table {
+    private:
+        struct slot {
+            KeyT prefix;
+            unsigned char level;
+            unsigned char distance;     // probe distance + 1, 0 marks an empty slot
+            NodeT node;
+        };
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<slot> allocator_t;
+        typedef std::allocator_traits<allocator_t> allocator_traits_t;
+
+        // Adapts the slots to the probing loops.
+        struct slot_view {
+            typedef slot entry;
+            slot *slots;
+            size_t mask_;
+            size_t mask() const { return mask_; }
+            unsigned char distance(size_t i) const { return slots[i].distance; }
+            bool holds(size_t i, int level, KeyT prefix) const { return slots[i].prefix == prefix && slots[i].level == level; }
+            const slot& load(size_t i) const { return slots[i]; }
+            void store(size_t i, const slot& entry_) { slots[i] = entry_; }
+            void vacate(size_t i) { slots[i].distance = 0; }
+        };
+
+        allocator_t _allocator;
+        slot *_slots;
+        size_t _mask;
+        int _shift;
+        size_t _size;
+        size_t _level_size[Width];
+
+        size_t home(int level, KeyT prefix) const;
+        slot_view view() const;
+        slot* locate(int level, KeyT prefix) const;
+        slot* locate(size_t i, int level, KeyT prefix) const;
+        void place(slot entry);
+        void place(slot entry, size_t i);
+        void remove(slot* found, int level);
+        void grow();
+        void rehash(size_t capacity);
+
+    public:
+        flat_level_table();
+        ~flat_level_table();
+
+        NodeT* find(int level, KeyT prefix);
+        const NodeT* find(int level, KeyT prefix) const;
+        NodeT* insert(int level, KeyT prefix, const NodeT& node);
+        void erase(int level, KeyT prefix);
+        void prefetch(int level, KeyT prefix) const;
+        void insert_path(KeyT key, int from, int to, const NodeT& node);
+        void erase_path(KeyT key, int from, int to);
+
+        size_t size(int level) const;
+        void clear();
+        void reserve(size_t keys);
+
+        double average_probe_length() const;
+        size_t memory_usage(level_memory* levels) const;
+    };
+
+    // Every possible prefix gets a slot, level i the 2^i slots after the
+    // 2^i - 1 of the levels above it, with a bitmap marking the slots in
+    // use. A find is a bit test and an index, nothing is hashed. Slots are
+    // allocated on the first insert but constructed only when used, so
+    // pages no prefix falls in are never touched. Meant for small widths,
+    // the table spans 2^Width - 1 slots.
+    template<class KeyT, class NodeT, int Width, class Allocator>
+    class dense_level_table {
+        static_assert(Width <= 24, "dense_level_table spans 2^Width slots, use it for small widths.");
+
+    private:
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<NodeT> allocator_t;
+        typedef std::allocator_traits<allocator_t> allocator_traits_t;
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<uint64_t> word_allocator_t;
+        typedef std::allocator_traits<word_allocator_t> word_traits_t;
+
+        static const size_t capacity = ((size_t)1 << Width) - 1;
+        static const size_t words = (capacity + 63) / 64;
+
+        allocator_t _allocator;
+        word_allocator_t _word_allocator;
+        NodeT *_slots;
+        uint64_t *_used;
+        size_t _size;
+        size_t _level_size[Width];
+
+        static size_t index(int level, KeyT prefix);
+        bool used(size_t i) const;
+        void allocate();
+        void destroy_nodes();
+
+    public:
+        dense_level_table();
+        ~dense_level_table();
+
+        NodeT* find(int level, KeyT prefix);
+        const NodeT* find(int level, KeyT prefix) const;
+        NodeT* insert(int level, KeyT prefix, const NodeT& node);
+        void erase(int level, KeyT prefix);
+        void prefetch(int level, KeyT prefix) const;
+        void insert_path(KeyT key, int from, int to, const NodeT& node);
+        void erase_path(KeyT key, int from, int to);
+
+        size_t size(int level) const;
+        void clear();
+        void reserve(size_t keys);
+
+        double average_probe_length() const;
+        size_t memory_usage(level_memory* levels) const;
+    };
+
+    // The top Top levels in a dense_level_table, the rest in the table Base
+    // makes. The top levels are the ones every search probes first and
+    // hold few prefixes, so there they cost an index instead of a hash.
+    // Level numbers are compile-time constants in the unrolled level
+    // search, so the choice between the two tables folds away.
+    template<class KeyT, class NodeT, int Width, class Allocator, int Top, class Base>
+    class direct_top_level_table {
+    private:
+        static const int top = Top < Width ? Top : Width;
+        typedef dense_level_table<KeyT, NodeT, top, Allocator> top_table_t;
+        typedef typename Base::template rebind<KeyT, NodeT, Width, Allocator>::other base_table_t;
+
+        top_table_t _top;
+        base_table_t _base;
+
+    public:
+        NodeT* find(int level, KeyT prefix);
+        const NodeT* find(int level, KeyT prefix) const;
+        NodeT* insert(int level, KeyT prefix, const NodeT& node);
+        void erase(int level, KeyT prefix);
+        void prefetch(int level, KeyT prefix) const;
+        void insert_path(KeyT key, int from, int to, const NodeT& node);
+        void erase_path(KeyT key, int from, int to);
+
+        size_t size(int level) const;
+        void clear();
+        void reserve(size_t keys);
+
+        double average_probe_length() const;
+        size_t memory_usage(level_memory* levels) const;
+    };
+
+    struct hashed_levels {
+        template<class KeyT, class NodeT, int Width, class Allocator>
+        struct rebind { typedef hashed_level_table<KeyT, NodeT, Width, Allocator> other; };
+    };
+
+    struct flat_levels {
+        template<class KeyT, class NodeT, int Width, class Allocator>
+        struct rebind { typedef flat_level_table<KeyT, NodeT, Width, Allocator> other; };
+    };
+
+    // Only for tries whose level i holds prefixes of i bits.
+    struct dense_levels {
+        template<class KeyT, class NodeT, int Width, class Allocator>
+        struct rebind { typedef dense_level_table<KeyT, NodeT, Width, Allocator> other; };
+    };
+
+    // Top levels direct-indexed, the rest in Base. Top is at most 24.
+    template<int Top = 16, class Base = hashed_levels>
+    struct direct_top_levels {
+        template<class KeyT, class NodeT, int Width, class Allocator>
+        struct rebind { typedef direct_top_level_table<KeyT, NodeT, Width, Allocator, Top, Base> other; };
+    };
+
+    // dense_levels while its table stays around a megabyte, hashed_levels
+    // beyond. Wider tries can still ask for dense_levels.
+    template<int Width>
+    struct default_levels {
+        typedef typename std::conditional<Width <= 16, dense_levels, hashed_levels>::type type;
+    };
+}
+
+#include "x_fast_trie_levels_impl.h"
+
+#endif
@@ -0,0 +1,663 @@
+//
+//  x_fast_trie_levels_impl.h
+//
+//  Level storage policies for kora::x_fast_trie.
+//  Author: Anil Anar.
+//
+
+#ifndef _x_fast_trie_levels_impl_h
+#define _x_fast_trie_levels_impl_h
+
+#define __TMPL      template<class KeyT, class NodeT, int Width, class Allocator>
+#define __HASHED    kora::hashed_level_table<KeyT, NodeT, Width, Allocator>
+#define __FLAT      kora::flat_level_table<KeyT, NodeT, Width, Allocator>
+#define __DENSE     kora::dense_level_table<KeyT, NodeT, Width, Allocator>
+#define __TOP_TMPL  template<class KeyT, class NodeT, int Width, class Allocator, int Top, class Base>
+#define __TOP       kora::direct_top_level_table<KeyT, NodeT, Width, Allocator, Top, Base>
+
+#include <cstdint>
+#include <utility>
+
+__TMPL
+__HASHED::hashed_level_table():
+hashed_level_table(std::make_index_sequence<Width>()) {
+}
+
+__TMPL
+template<size_t... Levels>
+__HASHED::hashed_level_table(std::index_sequence<Levels...>):
+_levels{ level_t(level_allocator(Levels))... } {
+}
+
+__TMPL
+const typename __HASHED::allocator_t& __HASHED::level_allocator(size_t) const {
+    return _allocator;
+}
+
+__TMPL
+NodeT* __HASHED::find(int level, KeyT prefix) {
+    typename level_t::iterator it = _levels[level].find(prefix);
+    if(it == _levels[level].end())
+        return NULL;
+    return &(it->second);
+}
+
+__TMPL
+const NodeT* __HASHED::find(int level, KeyT prefix) const {
+    typename level_t::const_iterator it = _levels[level].find(prefix);
+    if(it == _levels[level].end())
+        return NULL;
+    return &(it->second);
+}
+
+__TMPL
+NodeT* __HASHED::insert(int level, KeyT prefix, const NodeT& node) {
+    return &(_levels[level].insert({prefix, node}).first->second);
+}
+
+__TMPL
+void __HASHED::erase(int level, KeyT prefix) {
+    _levels[level].erase(prefix);
+}
+
+// Reading the bucket's head is a load the caller does not wait on, so
+// those of a group overlap; the first node of the chain is then fetched.
+__TMPL
+void __HASHED::prefetch(int level, KeyT prefix) const {
+    const level_t& table = _levels[level];
+    if(table.empty())
+        return;
+    size_t bucket = table.bucket(prefix);
+    typename level_t::const_local_iterator it = table.begin(bucket);
+    if(it != table.end(bucket))
+        bits::prefetch(&*it);
+}
+
+__TMPL
+void __HASHED::insert_path(KeyT key, int from, int to, const NodeT& node) {
+    for(int i = from; i < to; i++) {
+        _levels[i].insert({bits::prefix<KeyT, Width>(key, i), node});
+    }
+}
+
+__TMPL
+void __HASHED::erase_path(KeyT key, int from, int to) {
+    for(int i = from; i < to; i++) {
+        _levels[i].erase(bits::prefix<KeyT, Width>(key, i));
+    }
+}
+
+__TMPL
+size_t __HASHED::size(int level) const {
+    return _levels[level].size();
+}
+
+__TMPL
+void __HASHED::clear() {
+    for(int i = 0; i < Width; i++) {
+        _levels[i].clear();
+    }
+}
+
+__TMPL
+void __HASHED::reserve(size_t keys) {
+    // Level i holds at most 2^i prefixes.
+    for(int i = 0; i < Width; i++) {
+        size_t bound = i < 63 && ((size_t)1 << i) < keys ? (size_t)1 << i : keys;
+        _levels[i].reserve(bound);
+    }
+}
+
+__TMPL
+double __HASHED::average_probe_length() const {
+    // A hit on the k-th node of a bucket chain follows k links.
+    size_t entries = 0;
+    size_t probes = 0;
+    for(int i = 0; i < Width; i++) {
+        const level_t& level = _levels[i];
+        for(size_t b = 0; b < level.bucket_count(); b++) {
+            size_t chain = level.bucket_size(b);
+            probes += chain * (chain + 1) / 2;
+        }
+        entries += level.size();
+    }
+    return entries ? (double)probes / entries : 0;
+}
+
+__TMPL
+size_t __HASHED::memory_usage(level_memory* levels) const {
+    // A libstdc++ node is the link to the next node followed by the value.
+    typedef typename level_t::value_type value_t;
+    const size_t align = alignof(value_t) > alignof(void *) ? alignof(value_t) : alignof(void *);
+    const size_t node_size = (sizeof(void *) + sizeof(value_t) + align - 1) / align * align;
+    const bool heap = !allocator_releases<allocator_t>::value;
+    size_t node_bytes = 0;
+    for(int i = 0; i < Width; i++) {
+        level_memory& memory = levels[i];
+        memory.entries = _levels[i].size();
+        memory.buckets = _levels[i].bucket_count();
+        memory.node_bytes = memory.entries * node_size;
+        node_bytes += memory.node_bytes;
+        memory.bucket_bytes = memory.buckets * sizeof(void *);
+        memory.overhead = 0;
+        if(heap)
+            memory.overhead = memory.entries * (bits::heap_block_bytes(node_size) - node_size);
+        // A single bucket lives inside the map itself.
+        if(memory.buckets > 1)
+            memory.overhead += bits::heap_block_bytes(memory.bucket_bytes) - memory.bucket_bytes;
+        else
+            memory.bucket_bytes = 0;
+    }
+    return arena_overhead(std::integral_constant<bool, !heap>(), node_bytes);
+}
+
+__TMPL
+size_t __HASHED::arena_overhead(std::false_type, size_t) const {
+    return 0;
+}
+
+// What the levels' arena reserved that no node occupies, shared by all levels.
+__TMPL
+size_t __HASHED::arena_overhead(std::true_type, size_t used) const {
+    size_t reserved = _allocator.reserved_bytes();
+    return reserved > used ? reserved - used : 0;
+}
+
+__TMPL
+__FLAT::flat_level_table():
+_slots(NULL),
+_mask(0),
+_shift(64),
+_size(0) {
+    for(int i = 0; i < Width; i++) {
+        _level_size[i] = 0;
+    }
+}
+
+__TMPL
+__FLAT::~flat_level_table() {
+    if(!_slots)
+        return;
+    for(size_t i = 0; i <= _mask; i++) {
+        allocator_traits_t::destroy(_allocator, _slots + i);
+    }
+    allocator_traits_t::deallocate(_allocator, _slots, _mask + 1);
+}
+
+__TMPL
+size_t __FLAT::home(int level, KeyT prefix) const {
+    return (size_t)(bits::level_hash(level, (uint64_t)prefix) >> _shift);
+}
+
+__TMPL
+typename __FLAT::slot_view __FLAT::view() const {
+    slot_view view_ = { _slots, _mask };
+    return view_;
+}
+
+__TMPL
+typename __FLAT::slot* __FLAT::locate(int level, KeyT prefix) const {
+    if(!_size)
+        return NULL;
+    return locate(home(level, prefix), level, prefix);
+}
+
+// Probes from slot i, the home of (level, prefix).
+__TMPL
+typename __FLAT::slot* __FLAT::locate(size_t i, int level, KeyT prefix) const {
+    size_t found = probing::locate(view(), i, level, prefix);
+    return found <= _mask ? _slots + found : NULL;
+}
+
+__TMPL
+NodeT* __FLAT::find(int level, KeyT prefix) {
+    slot *found = locate(level, prefix);
+    return found ? &(found->node) : NULL;
+}
+
+__TMPL
+const NodeT* __FLAT::find(int level, KeyT prefix) const {
+    const slot *found = locate(level, prefix);
+    return found ? &(found->node) : NULL;
+}
+
+__TMPL
+void __FLAT::place(slot entry) {
+    place(entry, home(entry.level, entry.prefix));
+}
+
+__TMPL
+void __FLAT::place(slot entry, size_t i) {
+    slot_view view_ = view();
+    if(!probing::place(view_, entry, i)) {
+        // Pathologically long run, spread it over a larger table.
+        grow();
+        place(entry);
+    }
+}
+
+__TMPL
+NodeT* __FLAT::insert(int level, KeyT prefix, const NodeT& node) {
+    if((_size + 1) * 8 > (_mask + 1) * 7 || !_slots)
+        grow();
+    slot entry;
+    entry.prefix = prefix;
+    entry.level = (unsigned char)level;
+    entry.node = node;
+    place(entry);
+    _size++;
+    _level_size[level]++;
+    return &(locate(level, prefix)->node);
+}
+
+__TMPL
+void __FLAT::erase(int level, KeyT prefix) {
+    slot *found = locate(level, prefix);
+    if(found)
+        remove(found, level);
+}
+
+__TMPL
+void __FLAT::remove(slot* found, int level) {
+    slot_view view_ = view();
+    probing::remove(view_, found - _slots);
+    _size--;
+    _level_size[level]--;
+}
+
+__TMPL
+void __FLAT::prefetch(int level, KeyT prefix) const {
+    if(_slots)
+        bits::prefetch(_slots + home(level, prefix));
+}
+
+// The hashes of the whole path come from one bits::level_hashes call and
+// every home slot is prefetched before the first is written, so the
+// misses of the levels overlap.
+__TMPL
+void __FLAT::insert_path(KeyT key, int from, int to, const NodeT& node) {
+    if(from >= to)
+        return;
+    while(!_slots || (_size + to - from) * 8 > (_mask + 1) * 7) {
+        grow();
+    }
+    uint64_t hashes[Width];
+    bits::level_hashes((uint64_t)key, Width, from, to, hashes);
+    for(int i = 0; i < to - from; i++) {
+        bits::prefetch(_slots + (hashes[i] >> _shift));
+    }
+    for(int i = from; i < to; i++) {
+        slot entry;
+        entry.prefix = bits::prefix<KeyT, Width>(key, i);
+        entry.level = (unsigned char)i;
+        entry.node = node;
+        // A pathological run grows the table, so homes follow _shift.
+        place(entry, hashes[i - from] >> _shift);
+        _size++;
+        _level_size[i]++;
+    }
+}
+
+__TMPL
+void __FLAT::erase_path(KeyT key, int from, int to) {
+    if(from >= to || !_size)
+        return;
+    uint64_t hashes[Width];
+    bits::level_hashes((uint64_t)key, Width, from, to, hashes);
+    for(int i = 0; i < to - from; i++) {
+        bits::prefetch(_slots + (hashes[i] >> _shift));
+    }
+    for(int i = from; i < to; i++) {
+        slot *found = locate(hashes[i - from] >> _shift, i, bits::prefix<KeyT, Width>(key, i));
+        if(found)
+            remove(found, i);
+    }
+}
+
+__TMPL
+void __FLAT::grow() {
+    rehash(_slots ? (_mask + 1) * 2 : 16);
+}
+
+__TMPL
+void __FLAT::rehash(size_t capacity) {
+    slot *old_slots = _slots;
+    size_t old_capacity = _slots ? _mask + 1 : 0;
+
+    _slots = allocator_traits_t::allocate(_allocator, capacity);
+    for(size_t i = 0; i < capacity; i++) {
+        allocator_traits_t::construct(_allocator, _slots + i);
+        _slots[i].distance = 0;
+    }
+    _mask = capacity - 1;
+    _shift = 64;
+    for(size_t c = capacity; c > 1; c >>= 1) {
+        _shift--;
+    }
+
+    for(size_t i = 0; i < old_capacity; i++) {
+        if(old_slots[i].distance)
+            place(old_slots[i]);
+        allocator_traits_t::destroy(_allocator, old_slots + i);
+    }
+    if(old_slots)
+        allocator_traits_t::deallocate(_allocator, old_slots, old_capacity);
+}
+
+__TMPL
+size_t __FLAT::size(int level) const {
+    return _level_size[level];
+}
+
+__TMPL
+void __FLAT::clear() {
+    for(size_t i = 0; _slots && i <= _mask; i++) {
+        _slots[i].distance = 0;
+    }
+    _size = 0;
+    for(int i = 0; i < Width; i++) {
+        _level_size[i] = 0;
+    }
+}
+
+__TMPL
+void __FLAT::reserve(size_t keys) {
+    size_t entries = 0;
+    for(int i = 0; i < Width; i++) {
+        entries += i < 63 && ((size_t)1 << i) < keys ? (size_t)1 << i : keys;
+    }
+    size_t capacity = 16;
+    while(capacity * 7 < entries * 8) {
+        capacity *= 2;
+    }
+    if(!_slots || capacity > _mask + 1)
+        rehash(capacity);
+}
+
+__TMPL
+double __FLAT::average_probe_length() const {
+    size_t probes = 0;
+    for(size_t i = 0; _slots && i <= _mask; i++) {
+        probes += _slots[i].distance;
+    }
+    return _size ? (double)probes / _size : 0;
+}
+
+__TMPL
+size_t __FLAT::memory_usage(level_memory* levels) const {
+    for(int i = 0; i < Width; i++) {
+        level_memory& memory = levels[i];
+        memory.entries = _level_size[i];
+        memory.buckets = 0;
+        memory.node_bytes = memory.entries * sizeof(slot);
+        memory.bucket_bytes = 0;
+        memory.overhead = 0;
+    }
+    if(!_slots)
+        return 0;
+    size_t capacity = _mask + 1;
+    size_t shared = (capacity - _size) * sizeof(slot);
+    if(!allocator_releases<allocator_t>::value)
+        shared += bits::heap_block_bytes(capacity * sizeof(slot)) - capacity * sizeof(slot);
+    return shared;
+}
+
+__TMPL
+__DENSE::dense_level_table():
+_slots(NULL),
+_used(NULL),
+_size(0) {
+    for(int i = 0; i < Width; i++) {
+        _level_size[i] = 0;
+    }
+}
+
+__TMPL
+__DENSE::~dense_level_table() {
+    if(!_slots)
+        return;
+    destroy_nodes();
+    allocator_traits_t::deallocate(_allocator, _slots, capacity);
+    word_traits_t::deallocate(_word_allocator, _used, words);
+}
+
+__TMPL
+size_t __DENSE::index(int level, KeyT prefix) {
+    return ((size_t)1 << level) - 1 + (size_t)prefix;
+}
+
+__TMPL
+bool __DENSE::used(size_t i) const {
+    return (_used[i >> 6] >> (i & 63)) & 1;
+}
+
+__TMPL
+void __DENSE::allocate() {
+    _slots = allocator_traits_t::allocate(_allocator, capacity);
+    _used = word_traits_t::allocate(_word_allocator, words);
+    for(size_t w = 0; w < words; w++) {
+        _used[w] = 0;
+    }
+}
+
+// Visits the slots in use a bitmap word at a time, clearing the bitmap.
+__TMPL
+void __DENSE::destroy_nodes() {
+    for(size_t w = 0; _size && w < words; w++) {
+        uint64_t word = _used[w];
+        _size -= __builtin_popcountll(word);
+        while(word) {
+            allocator_traits_t::destroy(_allocator, _slots + w * 64 + __builtin_ctzll(word));
+            word &= word - 1;
+        }
+        _used[w] = 0;
+    }
+    _size = 0;
+}
+
+__TMPL
+NodeT* __DENSE::find(int level, KeyT prefix) {
+    size_t i = index(level, prefix);
+    if(!_size || !used(i))
+        return NULL;
+    return _slots + i;
+}
+
+__TMPL
+const NodeT* __DENSE::find(int level, KeyT prefix) const {
+    size_t i = index(level, prefix);
+    if(!_size || !used(i))
+        return NULL;
+    return _slots + i;
+}
+
+__TMPL
+NodeT* __DENSE::insert(int level, KeyT prefix, const NodeT& node) {
+    if(!_slots)
+        allocate();
+    size_t i = index(level, prefix);
+    if(used(i))
+        return _slots + i;
+    allocator_traits_t::construct(_allocator, _slots + i, node);
+    _used[i >> 6] |= (uint64_t)1 << (i & 63);
+    _size++;
+    _level_size[level]++;
+    return _slots + i;
+}
+
+__TMPL
+void __DENSE::erase(int level, KeyT prefix) {
+    size_t i = index(level, prefix);
+    if(!_size || !used(i))
+        return;
+    allocator_traits_t::destroy(_allocator, _slots + i);
+    _used[i >> 6] &= ~((uint64_t)1 << (i & 63));
+    _size--;
+    _level_size[level]--;
+}
+
+__TMPL
+void __DENSE::prefetch(int level, KeyT prefix) const {
+    if(_slots)
+        bits::prefetch(_slots + index(level, prefix));
+}
+
+__TMPL
+void __DENSE::insert_path(KeyT key, int from, int to, const NodeT& node) {
+    for(int i = from; i < to; i++) {
+        insert(i, bits::prefix<KeyT, Width>(key, i), node);
+    }
+}
+
+__TMPL
+void __DENSE::erase_path(KeyT key, int from, int to) {
+    for(int i = from; i < to; i++) {
+        erase(i, bits::prefix<KeyT, Width>(key, i));
+    }
+}
+
+__TMPL
+size_t __DENSE::size(int level) const {
+    return _level_size[level];
+}
+
+__TMPL
+void __DENSE::clear() {
+    if(_slots)
+        destroy_nodes();
+    for(int i = 0; i < Width; i++) {
+        _level_size[i] = 0;
+    }
+}
+
+__TMPL
+void __DENSE::reserve(size_t keys) {
+    if(!_slots && keys)
+        allocate();
+}
+
+__TMPL
+double __DENSE::average_probe_length() const {
+    return _size ? 1 : 0;
+}
+
+__TMPL
+size_t __DENSE::memory_usage(level_memory* levels) const {
+    for(int i = 0; i < Width; i++) {
+        level_memory& memory = levels[i];
+        memory.entries = _level_size[i];
+        memory.buckets = 0;
+        memory.node_bytes = memory.entries * sizeof(NodeT);
+        memory.bucket_bytes = 0;
+        memory.overhead = 0;
+    }
+    if(!_slots)
+        return 0;
+    // Empty slots count as reserved address space, most are never touched.
+    return (capacity - _size) * sizeof(NodeT) + words * sizeof(uint64_t);
+}
+
+__TOP_TMPL
+NodeT* __TOP::find(int level, KeyT prefix) {
+    if(level < top)
+        return _top.find(level, prefix);
+    return _base.find(level, prefix);
+}
+
+__TOP_TMPL
+const NodeT* __TOP::find(int level, KeyT prefix) const {
+    if(level < top)
+        return _top.find(level, prefix);
+    return _base.find(level, prefix);
+}
+
+__TOP_TMPL
+NodeT* __TOP::insert(int level, KeyT prefix, const NodeT& node) {
+    if(level < top)
+        return _top.insert(level, prefix, node);
+    return _base.insert(level, prefix, node);
+}
+
+__TOP_TMPL
+void __TOP::erase(int level, KeyT prefix) {
+    if(level < top)
+        _top.erase(level, prefix);
+    else
+        _base.erase(level, prefix);
+}
+
+__TOP_TMPL
+void __TOP::prefetch(int level, KeyT prefix) const {
+    if(level < top)
+        _top.prefetch(level, prefix);
+    else
+        _base.prefetch(level, prefix);
+}
+
+// The top table numbers prefixes by its own width, so it gets them one by
+// one; the base table takes its part of the path in bulk.
+__TOP_TMPL
+void __TOP::insert_path(KeyT key, int from, int to, const NodeT& node) {
+    for(; from < to && from < top; from++) {
+        _top.insert(from, bits::prefix<KeyT, Width>(key, from), node);
+    }
+    _base.insert_path(key, from, to, node);
+}
+
+__TOP_TMPL
+void __TOP::erase_path(KeyT key, int from, int to) {
+    for(; from < to && from < top; from++) {
+        _top.erase(from, bits::prefix<KeyT, Width>(key, from));
+    }
+    _base.erase_path(key, from, to);
+}
+
+__TOP_TMPL
+size_t __TOP::size(int level) const {
+    if(level < top)
+        return _top.size(level);
+    return _base.size(level);
+}
+
+__TOP_TMPL
+void __TOP::clear() {
+    _top.clear();
+    _base.clear();
+}
+
+__TOP_TMPL
+void __TOP::reserve(size_t keys) {
+    _top.reserve(keys);
+    _base.reserve(keys);
+}
+
+__TOP_TMPL
+double __TOP::average_probe_length() const {
+    // Entries of the top levels take a single probe.
+    size_t top_entries = 0;
+    size_t base_entries = 0;
+    for(int i = 0; i < Width; i++) {
+        if(i < top)
+            top_entries += _top.size(i);
+        else
+            base_entries += _base.size(i);
+    }
+    if(!top_entries && !base_entries)
+        return 0;
+    return (top_entries + _base.average_probe_length() * base_entries) / (top_entries + base_entries);
+}
+
+// The base table reports all Width levels, its top ones empty.
+__TOP_TMPL
+size_t __TOP::memory_usage(level_memory* levels) const {
+    size_t shared = _base.memory_usage(levels);
+    return shared + _top.memory_usage(levels);
+}
+
+#undef __TOP
+#undef __TOP_TMPL
+#undef __DENSE
+#undef __FLAT
+#undef __HASHED
+#undef __TMPL
+#endif
@@ -0,0 +1,123 @@
+//
+//  y_fast_trie.h
+//
+//  Y-fast-trie built on top of kora::x_fast_trie.
+//  Author: Anil Anar.
+//
+
+#ifndef _y_fast_trie_h
+#define _y_fast_trie_h
+
+#include <map>
+#include <utility>
+#include <initializer_list>
+#include <memory>
+
+#include "x_fast_trie.h"
+#include "trie_memory.h"
+
+namespace kora {
+    // Keys are split into buckets of Θ(Width) consecutive keys. Every bucket is a
+    // balanced search tree and only its representative (a lower bound of the
+    // bucket's key range) is stored in an x-fast trie, so memory is linear in the
+    // number of keys while predecessor queries stay O(log Width). Levels is
+    // the level storage of that trie; it stays hashed_levels by default
+    // whatever Width is, as a dense table would span the whole universe.
+    template<class KeyT, int Width, class ValueT, class Allocator = std::allocator<std::pair<const KeyT, ValueT>>, class Levels = hashed_levels>
+    class y_fast_trie {
+    private:
+        template<bool IsConst>
+        class y_fast_trie_iterator;
+
+        typedef std::map<KeyT, ValueT, std::less<KeyT>, Allocator> bucket_t;
+        typedef x_fast_trie<KeyT, Width, bucket_t, std::allocator<std::pair<const KeyT, bucket_t>>, Levels> index_t;
+        typedef typename index_t::iterator bucket_iterator;
+        typedef typename index_t::const_iterator const_bucket_iterator;
+
+        static const size_t min_bucket_size = Width / 2;
+        static const size_t max_bucket_size = Width * 2;
+
+        size_t _count;
+        index_t _index;
+
+        bucket_iterator locate(const KeyT& key);
+        const_bucket_iterator locate(const KeyT& key) const;
+        bucket_iterator last_bucket();
+        const_bucket_iterator last_bucket() const;
+        template<class K, class... Args>
+        std::pair<bucket_iterator, typename bucket_t::iterator> emplace_key(K&& key, Args&&... args);
+        bucket_iterator rekey(bucket_iterator bucket, const KeyT& key);
+        void split(bucket_iterator bucket);
+        void rebalance(bucket_iterator bucket);
+
+    public:
+        typedef std::pair<const KeyT, ValueT>   value_type;
+        typedef y_fast_trie_iterator<false>     iterator;
+        typedef y_fast_trie_iterator<true>      const_iterator;
+
+        y_fast_trie();
+        virtual ~y_fast_trie();
+
+        ValueT& at(const KeyT& key);
+        const ValueT& at(const KeyT& key) const;
+
+        ValueT& operator[](const KeyT& key);
+        ValueT& operator[](KeyT&& key);
+
+        iterator begin();
+        iterator end();
+        const_iterator cbegin() const;
+        const_iterator cend() const;
+
+        bool empty() const;
+        size_t size() const;
+        size_t max_size() const;
+
+        void clear();
+
+        std::pair<iterator, bool> insert(const value_type& value);
+        template<class InputIt>
+        void insert(InputIt first, InputIt last);
+        void insert(std::initializer_list<value_type> ilist);
+
+        // Search the buckets once and build the value in place, nothing is
+        // constructed if key is present.
+        template<class... Args>
+        std::pair<iterator, bool> try_emplace(const KeyT& key, Args&&... args);
+        template<class... Args>
+        std::pair<iterator, bool> try_emplace(KeyT&& key, Args&&... args);
+
+        iterator    erase(const_iterator pos);
+        iterator    erase(const_iterator first, const_iterator last);
+        size_t      erase(const KeyT& key);
+
+        size_t count();
+        iterator find(const KeyT& key);
+        const_iterator find(const KeyT& key) const;
+        std::pair<iterator, iterator> equal_range(const KeyT& key);
+        std::pair<const_iterator, const_iterator> equal_range(const KeyT& key) const;
+
+        iterator lower_bound(const KeyT& key);
+        const_iterator lower_bound(const KeyT& key) const;
+
+        iterator upper_bound(const KeyT& key);
+        const_iterator upper_bound(const KeyT& key) const;
+
+        // The element with the largest key below key and the one with the
+        // smallest key above it, end() if there is none.
+        iterator predecessor(const KeyT& key);
+        const_iterator predecessor(const KeyT& key) const;
+
+        iterator successor(const KeyT& key);
+        const_iterator successor(const KeyT& key) const;
+
+        // The representatives' trie as x_fast_trie reports it, with the
+        // bucket tree nodes counted as leaves. Estimates for libstdc++
+        // and glibc malloc.
+        trie_memory memory_usage() const;
+    };
+}
+
+#include "y_fast_trie_impl.h"
+
+#endif
@@ -0,0 +1,495 @@
+//
+//  y_fast_trie_impl.h
+//
+//  Y-fast-trie built on top of kora::x_fast_trie.
+//  Author: Anil Anar.
+//
+
+#ifndef _y_fast_trie_impl_h
+#define _y_fast_trie_impl_h
+
+#define __TMPL      template<class KeyT, int Width, class ValueT, class Allocator, class Levels>
+#define __CLS       kora::y_fast_trie<KeyT, Width, ValueT, Allocator, Levels>
+#define __INNER     typename __CLS
+
+#include <stdexcept>
+#include <iterator>
+#include <type_traits>
+#include <tuple>
+
+__TMPL
+template<bool IsConst>
+class __CLS::y_fast_trie_iterator : public std::iterator<std::bidirectional_iterator_tag, value_type, size_t> {
+
+protected:
+    typedef typename std::conditional<IsConst, const value_type, value_type>::type ValueTypeT;
+    typedef typename std::conditional<IsConst, const __CLS, __CLS>::type owner_t;
+    typedef typename std::conditional<IsConst, const_bucket_iterator, bucket_iterator>::type index_iterator;
+    typedef typename std::conditional<IsConst, typename bucket_t::const_iterator, typename bucket_t::iterator>::type item_iterator;
+
+    friend class __CLS;
+    template<bool>
+    friend class y_fast_trie_iterator;
+
+    owner_t *_owner;
+    index_iterator _bucket;
+    item_iterator _item;
+    y_fast_trie_iterator(owner_t *owner, index_iterator bucket, item_iterator item):
+    _owner(owner),
+    _bucket(bucket),
+    _item(item) {
+    }
+public:
+    // A template is never the copy constructor, copies stay implicit.
+    template<bool OtherConst, class = typename std::enable_if<IsConst && !OtherConst>::type>
+    y_fast_trie_iterator(const y_fast_trie_iterator<OtherConst>& other):
+    _owner(other._owner),
+    _bucket(other._bucket),
+    _item(other._item) {
+    }
+    ValueTypeT& operator*() const { return *_item; }
+    ValueTypeT* operator->() const { return &(*_item); }
+    const y_fast_trie_iterator<IsConst>& operator++() {
+        ++_item;
+        if(_item == _bucket->second.end()) {
+            ++_bucket;
+            if(_bucket != _owner->_index.cend())
+                _item = _bucket->second.begin();
+        }
+        return *this;
+    }
+    y_fast_trie_iterator<IsConst> operator++(int) {
+        y_fast_trie_iterator<IsConst> old = *this;
+        ++(*this);
+        return old;
+    }
+    const y_fast_trie_iterator<IsConst>& operator--() {
+        if(_bucket == _owner->_index.cend()) {
+            _bucket = _owner->last_bucket();
+            _item = _bucket->second.end();
+        } else if(_item == _bucket->second.begin()) {
+            --_bucket;
+            _item = _bucket->second.end();
+        }
+        --_item;
+        return *this;
+    }
+    y_fast_trie_iterator<IsConst> operator--(int) {
+        y_fast_trie_iterator<IsConst> old = *this;
+        --(*this);
+        return old;
+    }
+    bool operator==(const y_fast_trie_iterator<IsConst>& other) const {
+        if(_bucket != other._bucket)
+            return false;
+        return _bucket == _owner->_index.cend() || _item == other._item;
+    }
+    bool operator!=(const y_fast_trie_iterator<IsConst>& other) const {
+        return !(*this == other);
+    }
+};
+
+__TMPL
+__CLS::y_fast_trie():
+_count(0) {
+}
+
+__TMPL
+__CLS::~y_fast_trie() {
+}
+
+__TMPL
+ValueT& __CLS::at(const KeyT& key) {
+    iterator it = find(key);
+    if(it != end())
+        return it->second;
+    throw std::out_of_range("Specified key does not exist.");
+}
+
+__TMPL
+const ValueT& __CLS::at(const KeyT& key) const {
+    const_iterator it = find(key);
+    if(it != cend())
+        return it->second;
+    throw std::out_of_range("Specified key does not exist.");
+}
+
+__TMPL
+ValueT& __CLS::operator[](const KeyT& key) {
+    return try_emplace(key).first->second;
+}
+
+__TMPL
+ValueT& __CLS::operator[](KeyT&& key) {
+    return try_emplace(std::move(key)).first->second;
+}
+
+__TMPL
+__INNER::iterator __CLS::begin() {
+    bucket_iterator first = _index.begin();
+    if(first == _index.end())
+        return end();
+    return iterator(this, first, first->second.begin());
+}
+
+__TMPL
+__INNER::iterator __CLS::end() {
+    return iterator(this, _index.end(), typename bucket_t::iterator());
+}
+
+__TMPL
+__INNER::const_iterator __CLS::cbegin() const {
+    const_bucket_iterator first = _index.cbegin();
+    if(first == _index.cend())
+        return cend();
+    return const_iterator(this, first, first->second.begin());
+}
+
+__TMPL
+__INNER::const_iterator __CLS::cend() const {
+    return const_iterator(this, _index.cend(), typename bucket_t::const_iterator());
+}
+
+__TMPL
+bool __CLS::empty() const {
+    return _count == 0;
+}
+
+__TMPL
+size_t __CLS::size() const {
+    return _count;
+}
+
+__TMPL
+size_t __CLS::max_size() const {
+    KeyT zero = 0;
+    return ~zero;
+}
+
+__TMPL
+void __CLS::clear() {
+    _index.clear();
+    _count = 0;
+}
+
+__TMPL
+std::pair<__INNER::iterator, bool> __CLS::insert(const value_type &value) {
+    size_t count = _count;
+    std::pair<bucket_iterator, typename bucket_t::iterator> r = emplace_key(value.first, value.second);
+    return { iterator(this, r.first, r.second), _count != count };
+}
+
+__TMPL
+template<class... Args>
+std::pair<__INNER::iterator, bool> __CLS::try_emplace(const KeyT& key, Args&&... args) {
+    size_t count = _count;
+    std::pair<bucket_iterator, typename bucket_t::iterator> r = emplace_key(key, std::forward<Args>(args)...);
+    return { iterator(this, r.first, r.second), _count != count };
+}
+
+__TMPL
+template<class... Args>
+std::pair<__INNER::iterator, bool> __CLS::try_emplace(KeyT&& key, Args&&... args) {
+    size_t count = _count;
+    std::pair<bucket_iterator, typename bucket_t::iterator> r = emplace_key(std::move(key), std::forward<Args>(args)...);
+    return { iterator(this, r.first, r.second), _count != count };
+}
+
+// Finds the bucket of key and its place in it once, building the element
+// there only if key is missing. Returns where the element ended up.
+__TMPL
+template<class K, class... Args>
+std::pair<__INNER::bucket_iterator, typename __CLS::bucket_t::iterator> __CLS::emplace_key(K&& key, Args&&... args) {
+    bucket_iterator bucket = locate(key);
+    if(bucket == _index.end()) {
+        // Either the trie is empty or the key is below every representative;
+        // in both cases the key opens the first bucket's range.
+        bucket = _index.begin();
+        if(bucket == _index.end())
+            bucket = _index.insert({key, bucket_t()}).first;
+        else
+            bucket = rekey(bucket, key);
+    }
+
+    bucket_t& items = bucket->second;
+    typename bucket_t::iterator item = items.lower_bound(key);
+    if(item != items.end() && !(key < item->first))
+        return { bucket, item };
+    item = items.emplace_hint(item, std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+
+    _count++;
+    if(items.size() > max_bucket_size) {
+        KeyT inserted = item->first;
+        split(bucket);
+        bucket = locate(inserted);
+        item = bucket->second.find(inserted);
+    }
+    return { bucket, item };
+}
+
+__TMPL
+template<class InputIt>
+void __CLS::insert(InputIt first, InputIt last) {
+    for(;first != last; first++) {
+        insert(*first);
+    }
+}
+
+__TMPL
+void __CLS::insert(std::initializer_list<value_type> ilist) {
+    for(const value_type* it = ilist.begin(); it != ilist.end(); it++) {
+        insert(*it);
+    }
+}
+
+__TMPL
+__INNER::iterator __CLS::erase(const_iterator pos) {
+    bucket_iterator bucket = _index.find(pos._bucket->first);
+    typename bucket_t::iterator item = bucket->second.erase(pos._item);
+    _count--;
+
+    // Remember the successor by key, the buckets around it may be merged or split.
+    bool has_next = true;
+    KeyT next_key = 0;
+    if(item != bucket->second.end())
+        next_key = item->first;
+    else {
+        bucket_iterator next = bucket;
+        ++next;
+        if(next != _index.end())
+            next_key = next->second.begin()->first;
+        else
+            has_next = false;
+    }
+
+    rebalance(bucket);
+    if(!has_next)
+        return end();
+    return find(next_key);
+}
+
+__TMPL
+__INNER::iterator __CLS::erase(const_iterator first, const_iterator last) {
+    // Rebalancing may merge the bucket holding last, so compare by key instead.
+    bool bounded = last != cend();
+    KeyT last_key = bounded ? last->first : 0;
+    iterator it = first == cend() ? end() : find(first->first);
+    while(it != end() && (!bounded || it->first < last_key)) {
+        it = erase(it);
+    }
+
+    return it;
+}
+
+__TMPL
+size_t __CLS::erase(const KeyT& key) {
+    iterator it = find(key);
+    if(it == end())
+        return 0;
+    erase(it);
+    return 1;
+}
+
+__TMPL
+size_t __CLS::count() {
+    return _count;
+}
+
+__TMPL
+__INNER::iterator __CLS::find(const KeyT &key) {
+    bucket_iterator bucket = locate(key);
+    if(bucket == _index.end())
+        return end();
+    typename bucket_t::iterator item = bucket->second.find(key);
+    if(item == bucket->second.end())
+        return end();
+    return iterator(this, bucket, item);
+}
+
+__TMPL
+__INNER::const_iterator __CLS::find(const KeyT &key) const {
+    const_bucket_iterator bucket = locate(key);
+    if(bucket == _index.cend())
+        return cend();
+    typename bucket_t::const_iterator item = bucket->second.find(key);
+    if(item == bucket->second.end())
+        return cend();
+    return const_iterator(this, bucket, item);
+}
+
+__TMPL
+std::pair<__INNER::iterator, __INNER::iterator> __CLS::equal_range(const KeyT& key) {
+    return { lower_bound(key), upper_bound(key) };
+}
+
+__TMPL
+std::pair<__INNER::const_iterator, __INNER::const_iterator> __CLS::equal_range(const KeyT& key) const {
+    return { lower_bound(key), upper_bound(key) };
+}
+
+__TMPL
+__INNER::iterator __CLS::lower_bound(const KeyT& key) {
+    bucket_iterator bucket = locate(key);
+    if(bucket == _index.end())
+        return begin();
+    iterator it(this, bucket, bucket->second.lower_bound(key));
+    if(it._item == bucket->second.end()) {
+        --it._item;
+        ++it;
+    }
+    return it;
+}
+
+__TMPL
+__INNER::const_iterator __CLS::lower_bound(const KeyT& key) const {
+    const_bucket_iterator bucket = locate(key);
+    if(bucket == _index.cend())
+        return cbegin();
+    const_iterator it(this, bucket, bucket->second.lower_bound(key));
+    if(it._item == bucket->second.end()) {
+        --it._item;
+        ++it;
+    }
+    return it;
+}
+
+__TMPL
+__INNER::iterator __CLS::upper_bound(const KeyT& key) {
+    bucket_iterator bucket = locate(key);
+    if(bucket == _index.end())
+        return begin();
+    iterator it(this, bucket, bucket->second.upper_bound(key));
+    if(it._item == bucket->second.end()) {
+        --it._item;
+        ++it;
+    }
+    return it;
+}
+
+__TMPL
+__INNER::const_iterator __CLS::upper_bound(const KeyT& key) const {
+    const_bucket_iterator bucket = locate(key);
+    if(bucket == _index.cend())
+        return cbegin();
+    const_iterator it(this, bucket, bucket->second.upper_bound(key));
+    if(it._item == bucket->second.end()) {
+        --it._item;
+        ++it;
+    }
+    return it;
+}
+
+__TMPL
+__INNER::iterator __CLS::predecessor(const KeyT& key) {
+    iterator it = lower_bound(key);
+    if(it == begin())
+        return end();
+    return --it;
+}
+
+__TMPL
+__INNER::const_iterator __CLS::predecessor(const KeyT& key) const {
+    const_iterator it = lower_bound(key);
+    if(it == cbegin())
+        return cend();
+    return --it;
+}
+
+__TMPL
+__INNER::iterator __CLS::successor(const KeyT& key) {
+    return upper_bound(key);
+}
+
+__TMPL
+__INNER::const_iterator __CLS::successor(const KeyT& key) const {
+    return upper_bound(key);
+}
+
+__TMPL
+kora::trie_memory __CLS::memory_usage() const {
+    // A red-black tree node is its colour, three links and the value.
+    const size_t item_bytes = 4 * sizeof(void *) + sizeof(value_type);
+    trie_memory memory = _index.memory_usage();
+    memory.leaf_bytes += _count * item_bytes;
+    memory.allocator_overhead += _count * (bits::heap_block_bytes(item_bytes) - item_bytes);
+    memory.leaf_count = _count;
+    memory.object_bytes = sizeof(*this);
+    return memory;
+}
+
+// The bucket whose range holds key: the one of the largest representative
+// not above key, end if key is below them all.
+__TMPL
+__INNER::bucket_iterator __CLS::locate(const KeyT& key) {
+    bucket_iterator bucket = _index.find(key);
+    if(bucket != _index.end())
+        return bucket;
+    return _index.predecessor(key);
+}
+
+__TMPL
+__INNER::const_bucket_iterator __CLS::locate(const KeyT& key) const {
+    const_bucket_iterator bucket = _index.find(key);
+    if(bucket != _index.cend())
+        return bucket;
+    return _index.predecessor(key);
+}
+
+__TMPL
+__INNER::bucket_iterator __CLS::last_bucket() {
+    return _index.rbegin();
+}
+
+__TMPL
+__INNER::const_bucket_iterator __CLS::last_bucket() const {
+    return _index.rcbegin();
+}
+
+__TMPL
+__INNER::bucket_iterator __CLS::rekey(bucket_iterator bucket, const KeyT& key) {
+    bucket_iterator rekeyed = _index.insert({key, bucket_t()}).first;
+    rekeyed->second.swap(bucket->second);
+    _index.erase(bucket);
+    return rekeyed;
+}
+
+__TMPL
+void __CLS::split(bucket_iterator bucket) {
+    bucket_t& lower = bucket->second;
+    typename bucket_t::iterator middle = lower.begin();
+    std::advance(middle, lower.size() / 2);
+    bucket_iterator upper = _index.insert({middle->first, bucket_t()}).first;
+    upper->second.insert(std::make_move_iterator(middle), std::make_move_iterator(lower.end()));
+    lower.erase(middle, lower.end());
+}
+
+__TMPL
+void __CLS::rebalance(bucket_iterator bucket) {
+    if(bucket->second.empty()) {
+        _index.erase(bucket);
+        return;
+    }
+    if(bucket->second.size() >= min_bucket_size)
+        return;
+
+    // Merge the underfull bucket into a neighbour, the lower one keeps its
+    // representative, and split again if the merged bucket got too large.
+    bucket_iterator lower = bucket;
+    bucket_iterator upper = bucket;
+    ++upper;
+    if(upper == _index.end()) {
+        if(bucket == _index.begin())
+            return;
+        --lower;
+        upper = bucket;
+    }
+    lower->second.insert(std::make_move_iterator(upper->second.begin()), std::make_move_iterator(upper->second.end()));
+    _index.erase(upper);
+    if(lower->second.size() > max_bucket_size)
+        split(lower);
+}
+
+#undef __INNER
+#undef __CLS
+#undef __TMPL
+#endif
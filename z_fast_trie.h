@@ -0,0 +1,132 @@
+//
+//  z_fast_trie.h
+//
+//  Z-fast-trie: a compacted binary trie over the keys with a handle table
+//  for the level search.
+//  Author: Anil Anar.
+//
+
+#ifndef _z_fast_trie_h
+#define _z_fast_trie_h
+
+#include <cstdint>
+#include <utility>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+#include <iterator>
+
+#include "trie_bits.h"
+#include "trie_leaf.h"
+#include "x_fast_trie_levels.h"
+#include "trie_stats.h"
+#include "trie_memory.h"
+
+namespace kora {
+    // Only the n - 1 branching points of the keys' binary trie get a node,
+    // stored under its extent: the prefix where it branches. A node's name
+    // is its parent's extent and one more bit; the node covers the prefix
+    // lengths from its name to its extent. Its handle is the prefix of the
+    // length in that range with the most trailing zeros, and a second
+    // table maps handles to extents. Searching the handles of a key for the
+    // deepest node it passes through takes O(log Width) probes (the fat
+    // binary search of Belazzougui, Boldi, Pagh and Vigna), so lookups
+    // match x_fast_trie with O(n) table entries instead of O(n Width).
+    // Updates walk up from the changed node to fix the smallest and largest
+    // leaves of ancestors, one probe for each ancestor that changes.
+    template<class KeyT, int Width, class ValueT, class Allocator = std::allocator<std::pair<const KeyT, ValueT>>, class Levels = hashed_levels, class Stats = null_stats>
+    class z_fast_trie {
+        static_assert(Width >= 1 && Width <= 64, "Width must be between 1 and 64 bits.");
+
+    private:
+        struct z_node;
+        struct z_handle;
+        typedef trie_leaf<KeyT, ValueT> x_leaf_node;
+        struct exit_point;
+
+        typedef typename Levels::template rebind<KeyT, z_node, Width, Allocator>::other node_table_t;
+        typedef typename Levels::template rebind<KeyT, z_handle, Width, Allocator>::other handle_table_t;
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<x_leaf_node> node_allocator_t;
+        node_allocator_t _allocator;
+        typedef std::allocator_traits<node_allocator_t> node_traits_t;
+        typedef typename node_traits_t::pointer x_leaf_node_ptr;
+
+        size_t _count;
+        node_table_t _nodes;
+        handle_table_t _handles;
+        x_leaf_node* _leaf_list;
+        mutable Stats _stats;
+
+        static int fattest(int low, int high);
+        static int bit(KeyT key, int position);
+
+        void locate_exit(KeyT key, exit_point& exit) const;
+        void rename(int length, KeyT extent, int name);
+        void insert_handle(int name, int length, KeyT extent);
+        void erase_handle(int name, int length, KeyT extent);
+        x_leaf_node* ceiling_node(KeyT key) const;
+        x_leaf_node* find_node(KeyT key) const;
+        x_leaf_node* lower_node(KeyT key) const;
+        x_leaf_node* higher_node(KeyT key) const;
+        x_leaf_node* new_leaf(const std::pair<const KeyT, ValueT>& value);
+        void delete_leaf(x_leaf_node* leaf);
+
+    public:
+        typedef std::pair<const KeyT, ValueT>   value_type;
+        typedef trie_leaf_iterator<z_fast_trie, x_leaf_node, false> iterator;
+        typedef trie_leaf_iterator<z_fast_trie, x_leaf_node, true> const_iterator;
+
+        z_fast_trie();
+        virtual ~z_fast_trie();
+
+        ValueT& at(const KeyT& key);
+        const ValueT& at(const KeyT& key) const;
+
+        ValueT& operator[](const KeyT& key);
+
+        iterator begin();
+        iterator end();
+        const_iterator cbegin() const;
+        const_iterator cend() const;
+
+        bool empty() const;
+        size_t size() const;
+
+        void clear();
+
+        std::pair<iterator, bool> insert(const value_type& value);
+        template<class InputIt>
+        void insert(InputIt first, InputIt last);
+        void insert(std::initializer_list<value_type> ilist);
+
+        iterator    erase(const_iterator pos);
+        size_t      erase(const KeyT& key);
+
+        iterator find(const KeyT& key);
+        const_iterator find(const KeyT& key) const;
+
+        iterator lower_bound(const KeyT& key);
+        const_iterator lower_bound(const KeyT& key) const;
+
+        iterator upper_bound(const KeyT& key);
+        const_iterator upper_bound(const KeyT& key) const;
+
+        // The element with the largest key below key and the one with the
+        // smallest key above it, end() if there is none.
+        iterator predecessor(const KeyT& key);
+        const_iterator predecessor(const KeyT& key) const;
+
+        iterator successor(const KeyT& key);
+        const_iterator successor(const KeyT& key) const;
+
+        // As for x_fast_trie. memory_usage() reports 2 Width levels, the
+        // nodes by extent length followed by the handles by handle length.
+        trie_stats stats() const;
+        void reset_stats();
+        trie_memory memory_usage() const;
+    };
+}
+
+#include "z_fast_trie_impl.h"
+
+#endif
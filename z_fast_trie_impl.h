@@ -0,0 +1,522 @@
+//
+//  z_fast_trie_impl.h
+//
+//  Z-fast-trie: a compacted binary trie over the keys with a handle table
+//  for the level search.
+//  Author: Anil Anar.
+//
+
+#ifndef _z_fast_trie_impl_h
+#define _z_fast_trie_impl_h
+
+#define __TMPL      template<class KeyT, int Width, class ValueT, class Allocator, class Levels, class Stats>
+#define __CLS       kora::z_fast_trie<KeyT, Width, ValueT, Allocator, Levels, Stats>
+#define __INNER     typename __CLS
+
+#include <stdexcept>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+// A branching point, stored under its extent. left and right are the
+// smallest and largest leaf below it and split the largest leaf of its
+// left subtree, so split and split->right are the pair of neighbouring
+// leaves that branch here. name is the length of the node's name.
+__TMPL
+struct __CLS::z_node {
+    x_leaf_node* left;
+    x_leaf_node* right;
+    x_leaf_node* split;
+    int name;
+
+    z_node(): left(NULL), right(NULL), split(NULL), name(0) {}
+    z_node(x_leaf_node *l, x_leaf_node *r, x_leaf_node *s, int n): left(l), right(r), split(s), name(n) {}
+};
+
+// The extent of the node a handle belongs to, length bits long.
+__TMPL
+struct __CLS::z_handle {
+    KeyT extent;
+    int length;
+
+    z_handle(): extent(0), length(0) {}
+    z_handle(KeyT e, int l): extent(e), length(l) {}
+};
+
+// The node a key leaves the trie at: the leaves low to high below it, the
+// length of its name and that of its extent, Width for a leaf.
+__TMPL
+struct __CLS::exit_point {
+    x_leaf_node* low;
+    x_leaf_node* high;
+    int name;
+    int length;
+};
+
+__TMPL
+__CLS::z_fast_trie():
+_count(0),
+_leaf_list(NULL) {
+}
+
+__TMPL
+__CLS::~z_fast_trie() {
+    x_leaf_node *leaf = _leaf_list;
+    for(size_t i = 0; i < _count; i++) {
+        x_leaf_node *next = leaf->right;
+        node_traits_t::destroy(_allocator, leaf);
+        node_traits_t::deallocate(_allocator, leaf, 1);
+        leaf = next;
+    }
+}
+
+__TMPL
+ValueT& __CLS::at(const KeyT& key) {
+    iterator it = find(key);
+    if(it != end())
+        return (*it).second;
+    throw std::out_of_range("Specified key does not exist.");
+}
+
+__TMPL
+const ValueT& __CLS::at(const KeyT& key) const {
+    const_iterator it = find(key);
+    if(it != cend())
+        return (*it).second;
+    throw std::out_of_range("Specified key does not exist.");
+}
+
+__TMPL
+ValueT& __CLS::operator[](const KeyT& key) {
+    return (*insert(value_type(key, ValueT())).first).second;
+}
+
+__TMPL
+__INNER::iterator __CLS::begin() {
+    return iterator(_leaf_list, _leaf_list);
+}
+
+__TMPL
+__INNER::iterator __CLS::end() {
+    return iterator(_leaf_list, NULL);
+}
+
+__TMPL
+__INNER::const_iterator __CLS::cbegin() const {
+    return const_iterator(_leaf_list, _leaf_list);
+}
+
+__TMPL
+__INNER::const_iterator __CLS::cend() const {
+    return const_iterator(_leaf_list, NULL);
+}
+
+__TMPL
+bool __CLS::empty() const {
+    return _count == 0;
+}
+
+__TMPL
+size_t __CLS::size() const {
+    return _count;
+}
+
+__TMPL
+void __CLS::clear() {
+    _stats.begin(trie_erase);
+    x_leaf_node *leaf = _leaf_list;
+    for(size_t i = 0; i < _count; i++) {
+        x_leaf_node *next = leaf->right;
+        delete_leaf(leaf);
+        leaf = next;
+    }
+    _count = 0;
+    _leaf_list = NULL;
+    size_t nodes = 0;
+    for(int i = 0; i < Width; i++) {
+        nodes += _nodes.size(i) + _handles.size(i);
+    }
+    _stats.deallocation(nodes);
+    _nodes.clear();
+    _handles.clear();
+}
+
+// The key leaves its exit node at the first bit it differs from the leaves
+// below, so it becomes their new neighbour at one end, and a new node
+// branching there takes over the exit node's name. Ancestors whose
+// smallest or largest leaf was at that end get the new one; the ancestor
+// where the other neighbour branches off stops the walk.
+__TMPL
+std::pair<__INNER::iterator, bool> __CLS::insert(const value_type& value) {
+    _stats.begin(trie_insert);
+    KeyT key = value.first;
+    if(!_leaf_list) {
+        x_leaf_node *leaf = new_leaf(value);
+        leaves::insert_after<x_leaf_node>(_leaf_list, NULL, leaf);
+        _count++;
+        return { iterator(_leaf_list, leaf), true };
+    }
+
+    exit_point exit;
+    locate_exit(key, exit);
+    if(exit.low->key() == key)
+        return { iterator(_leaf_list, exit.low), false };
+    int length = bits::common_prefix<KeyT, Width>(key, exit.low->key());
+    bool before = bit(key, length) == 0;
+    x_leaf_node *predecessor;
+    x_leaf_node *outer;
+    if(before) {
+        predecessor = exit.low == _leaf_list ? NULL : exit.low->left;
+        outer = predecessor;
+    } else {
+        predecessor = exit.high;
+        outer = exit.high->right == _leaf_list ? NULL : exit.high->right;
+    }
+    int stop = -1;
+    if(outer)
+        stop = bits::common_prefix<KeyT, Width>(outer->key(), key);
+
+    x_leaf_node *leaf = new_leaf(value);
+    leaves::insert_after(_leaf_list, predecessor, leaf);
+    _count++;
+
+    if(exit.length < Width)
+        rename(exit.length, bits::prefix<KeyT, Width>(exit.low->key(), exit.length), length + 1);
+    KeyT extent = bits::prefix<KeyT, Width>(key, length);
+    if(before)
+        _nodes.insert(length, extent, z_node(leaf, exit.high, leaf, exit.name));
+    else
+        _nodes.insert(length, extent, z_node(exit.low, leaf, exit.high, exit.name));
+    _stats.hash_probe();
+    _stats.allocation();
+    insert_handle(exit.name, length, extent);
+
+    for(int t = exit.name - 1; t > stop;) {
+        z_node *node = _nodes.find(t, bits::prefix<KeyT, Width>(key, t));
+        _stats.hash_probe();
+        if(before)
+            node->left = leaf;
+        else
+            node->right = leaf;
+        t = node->name - 1;
+    }
+    if(!before && outer) {
+        _nodes.find(stop, bits::prefix<KeyT, Width>(key, stop))->split = leaf;
+        _stats.hash_probe();
+    }
+    return { iterator(_leaf_list, leaf), true };
+}
+
+__TMPL
+template<class InputIt>
+void __CLS::insert(InputIt first, InputIt last) {
+    for(; first != last; ++first) {
+        insert(*first);
+    }
+}
+
+__TMPL
+void __CLS::insert(std::initializer_list<value_type> ilist) {
+    insert(ilist.begin(), ilist.end());
+}
+
+// The leaf's parent branches where the leaf shares most with a neighbour.
+// It goes, its other subtree takes over its name, and ancestors whose
+// smallest or largest leaf was the erased one get its neighbour instead.
+__TMPL
+__INNER::iterator __CLS::erase(const_iterator pos) {
+    _stats.begin(trie_erase);
+    x_leaf_node *leaf = pos._node;
+    KeyT key = leaf->key();
+    x_leaf_node *predecessor = leaf == _leaf_list ? NULL : leaf->left;
+    x_leaf_node *successor = leaf->right == _leaf_list ? NULL : leaf->right;
+    if(predecessor || successor) {
+        int before = predecessor ? bits::common_prefix<KeyT, Width>(predecessor->key(), key) : -1;
+        int after = successor ? bits::common_prefix<KeyT, Width>(key, successor->key()) : -1;
+        bool is_min = after > before;
+        int length = is_min ? after : before;
+        int stop = is_min ? before : after;
+
+        KeyT extent = bits::prefix<KeyT, Width>(key, length);
+        z_node *parent = _nodes.find(length, extent);
+        _stats.hash_probe();
+        int name = parent->name;
+        x_leaf_node *low = is_min ? successor : parent->left;
+        x_leaf_node *high = is_min ? parent->right : predecessor;
+        erase_handle(name, length, extent);
+        _nodes.erase(length, extent);
+        _stats.hash_probe();
+        _stats.deallocation();
+        if(low != high) {
+            int sibling = bits::common_prefix<KeyT, Width>(low->key(), high->key());
+            rename(sibling, bits::prefix<KeyT, Width>(low->key(), sibling), name);
+        }
+
+        for(int t = name - 1; t > stop;) {
+            z_node *node = _nodes.find(t, bits::prefix<KeyT, Width>(key, t));
+            _stats.hash_probe();
+            if(is_min)
+                node->left = successor;
+            else
+                node->right = predecessor;
+            t = node->name - 1;
+        }
+        if(!is_min && successor) {
+            _nodes.find(stop, bits::prefix<KeyT, Width>(key, stop))->split = predecessor;
+            _stats.hash_probe();
+        }
+    }
+    leaves::unlink(_leaf_list, leaf);
+    _count--;
+    delete_leaf(leaf);
+    return iterator(_leaf_list, successor);
+}
+
+__TMPL
+size_t __CLS::erase(const KeyT& key) {
+    const_iterator it = find(key);
+    if(it == cend())
+        return 0;
+    erase(it);
+    return 1;
+}
+
+__TMPL
+__INNER::iterator __CLS::find(const KeyT& key) {
+    _stats.begin(trie_lookup);
+    return iterator(_leaf_list, find_node(key));
+}
+
+__TMPL
+__INNER::const_iterator __CLS::find(const KeyT& key) const {
+    _stats.begin(trie_lookup);
+    return const_iterator(_leaf_list, find_node(key));
+}
+
+__TMPL
+__INNER::iterator __CLS::lower_bound(const KeyT& key) {
+    _stats.begin(trie_lookup);
+    return iterator(_leaf_list, ceiling_node(key));
+}
+
+__TMPL
+__INNER::const_iterator __CLS::lower_bound(const KeyT& key) const {
+    _stats.begin(trie_lookup);
+    return const_iterator(_leaf_list, ceiling_node(key));
+}
+
+__TMPL
+__INNER::iterator __CLS::upper_bound(const KeyT& key) {
+    _stats.begin(trie_lookup);
+    return iterator(_leaf_list, higher_node(key));
+}
+
+__TMPL
+__INNER::const_iterator __CLS::upper_bound(const KeyT& key) const {
+    _stats.begin(trie_lookup);
+    return const_iterator(_leaf_list, higher_node(key));
+}
+
+__TMPL
+__INNER::iterator __CLS::predecessor(const KeyT& key) {
+    _stats.begin(trie_lookup);
+    return iterator(_leaf_list, lower_node(key));
+}
+
+__TMPL
+__INNER::const_iterator __CLS::predecessor(const KeyT& key) const {
+    _stats.begin(trie_lookup);
+    return const_iterator(_leaf_list, lower_node(key));
+}
+
+__TMPL
+__INNER::iterator __CLS::successor(const KeyT& key) {
+    _stats.begin(trie_lookup);
+    return iterator(_leaf_list, higher_node(key));
+}
+
+__TMPL
+__INNER::const_iterator __CLS::successor(const KeyT& key) const {
+    _stats.begin(trie_lookup);
+    return const_iterator(_leaf_list, higher_node(key));
+}
+
+__TMPL
+kora::trie_stats __CLS::stats() const {
+    return _stats.snapshot();
+}
+
+__TMPL
+void __CLS::reset_stats() {
+    _stats.reset();
+}
+
+__TMPL
+kora::trie_memory __CLS::memory_usage() const {
+    trie_memory memory;
+    memory.levels.resize(2 * Width);
+    memory.shared_table_bytes = _nodes.memory_usage(&memory.levels[0]);
+    memory.shared_table_bytes += _handles.memory_usage(&memory.levels[Width]);
+    memory.leaf_count = _count;
+    memory.leaf_bytes = _count * sizeof(x_leaf_node);
+    memory.allocator_overhead = 0;
+    if(!allocator_releases<node_allocator_t>::value)
+        memory.allocator_overhead = _count * (bits::heap_block_bytes(sizeof(x_leaf_node)) - sizeof(x_leaf_node));
+    memory.object_bytes = sizeof(*this);
+    return memory;
+}
+
+// The number in [low, high] with the most trailing zeros, 0 if low is.
+__TMPL
+int __CLS::fattest(int low, int high) {
+    if(low == 0)
+        return 0;
+    int shift = 63 - __builtin_clzll((uint64_t)((low - 1) ^ high));
+    return (high >> shift) << shift;
+}
+
+// Bit position of key counting from the top, position 0 the highest.
+__TMPL
+int __CLS::bit(KeyT key, int position) {
+    return (int)(((uint64_t)key >> (Width - 1 - position)) & 1);
+}
+
+// Fat binary search over the prefix lengths of key, keeping (low, high]
+// around the extent of the deepest node key passes all the way through.
+// A handle found belongs to a node on key's path; if key also matches its
+// extent the search goes below it, otherwise key leaves the trie there.
+// A missing handle leaves every deeper length out, a node there would
+// have had it as its handle. Without a node the exit is the single leaf.
+__TMPL
+void __CLS::locate_exit(KeyT key, exit_point& exit) const {
+    int low = -1;
+    int high = Width - 1;
+    while(low < high) {
+        int f = fattest(low + 1, high);
+        const z_handle *handle = _handles.find(f, bits::prefix<KeyT, Width>(key, f));
+        _stats.level_search();
+        _stats.hash_probe();
+        if(!handle) {
+            high = f - 1;
+        } else if(bits::prefix<KeyT, Width>(key, handle->length) == handle->extent) {
+            low = handle->length;
+        } else {
+            const z_node *node = _nodes.find(handle->length, handle->extent);
+            _stats.hash_probe();
+            exit.low = node->left;
+            exit.high = node->right;
+            exit.name = node->name;
+            exit.length = handle->length;
+            return;
+        }
+    }
+    if(low < 0) {
+        exit.low = _leaf_list;
+        exit.high = _leaf_list;
+        exit.name = 0;
+        exit.length = Width;
+        return;
+    }
+
+    const z_node *node = _nodes.find(low, bits::prefix<KeyT, Width>(key, low));
+    _stats.hash_probe();
+    if(bit(key, low) == 0) {
+        exit.low = node->left;
+        exit.high = node->split;
+    } else {
+        exit.low = node->split->right;
+        exit.high = node->right;
+    }
+    exit.name = low + 1;
+    exit.length = exit.low == exit.high ? Width : bits::common_prefix<KeyT, Width>(exit.low->key(), exit.high->key());
+}
+
+// Gives the node with the extent of length bits a new name, moving its
+// handle along if that changes it.
+__TMPL
+void __CLS::rename(int length, KeyT extent, int name) {
+    z_node *node = _nodes.find(length, extent);
+    _stats.hash_probe();
+    int old_name = node->name;
+    node->name = name;
+    if(fattest(old_name, length) != fattest(name, length)) {
+        erase_handle(old_name, length, extent);
+        insert_handle(name, length, extent);
+    }
+}
+
+__TMPL
+void __CLS::insert_handle(int name, int length, KeyT extent) {
+    int f = fattest(name, length);
+    _handles.insert(f, extent >> (length - f), z_handle(extent, length));
+    _stats.hash_probe();
+    _stats.allocation();
+}
+
+__TMPL
+void __CLS::erase_handle(int name, int length, KeyT extent) {
+    int f = fattest(name, length);
+    _handles.erase(f, extent >> (length - f));
+    _stats.hash_probe();
+    _stats.deallocation();
+}
+
+// Leaves below the exit node share more with each other than with key,
+// so key lies before all of them or after all of them.
+__TMPL
+__INNER::x_leaf_node* __CLS::ceiling_node(KeyT key) const {
+    if(!_leaf_list)
+        return NULL;
+    exit_point exit;
+    locate_exit(key, exit);
+    if(exit.low->key() == key)
+        return exit.low;
+    int length = bits::common_prefix<KeyT, Width>(key, exit.low->key());
+    if(bit(key, length) == 0)
+        return exit.low;
+    _stats.leaf_hop();
+    return exit.high->right == _leaf_list ? NULL : exit.high->right;
+}
+
+__TMPL
+__INNER::x_leaf_node* __CLS::find_node(KeyT key) const {
+    x_leaf_node *ceiling = ceiling_node(key);
+    if(!ceiling || ceiling->key() != key)
+        return NULL;
+    return ceiling;
+}
+
+__TMPL
+__INNER::x_leaf_node* __CLS::lower_node(KeyT key) const {
+    x_leaf_node *ceiling = ceiling_node(key);
+    if(!ceiling)
+        return _leaf_list ? _leaf_list->left : NULL;
+    _stats.leaf_hop();
+    return ceiling == _leaf_list ? NULL : ceiling->left;
+}
+
+__TMPL
+__INNER::x_leaf_node* __CLS::higher_node(KeyT key) const {
+    x_leaf_node *ceiling = ceiling_node(key);
+    if(!ceiling || ceiling->key() != key)
+        return ceiling;
+    _stats.leaf_hop();
+    if(ceiling->right == _leaf_list)
+        return NULL;
+    return ceiling->right;
+}
+
+__TMPL
+__INNER::x_leaf_node* __CLS::new_leaf(const std::pair<const KeyT, ValueT>& value) {
+    return leaves::create(_allocator, _stats, value);
+}
+
+__TMPL
+void __CLS::delete_leaf(x_leaf_node* leaf) {
+    leaves::destroy(_allocator, _stats, leaf);
+}
+
+#undef __INNER
+#undef __CLS
+#undef __TMPL
+#endif